@@ -5,130 +5,89 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <fstream>
 #include <vector>
 #include <iostream>
 #include <string>
 #include "shader.h"
+#include "geometryArena.h"
+#include "drawUniforms.h"
+#include "lod.h"
+#include "meshContainer.h"
+#include "textureArray.h"
 
 class CurveWithTexture {
 public:
     // Constructor
     CurveWithTexture(const std::string& vertexFilePath, const std::string& indexFilePath, unsigned int diffuseTex, unsigned int specularTex, float shiny)
         : diffuseTexture(diffuseTex), specularTexture(specularTex), shininess(shiny) {
-        loadVertices(vertexFilePath);
-        loadIndices(indexFilePath);
-        setupVAO();
+        // surface colours for the blended shading modes; the maps carry the look
+        material = MaterialTable::instance().add(glm::vec3(0.2f), glm::vec3(0.8f), glm::vec3(1.0f), shininess);
+        // a baked container next to the vertex file (see meshContainer.h) skips the text parsing
+        if (!loadContainer(meshContainerPath(vertexFilePath))) {
+            loadVertices(vertexFilePath);
+            loadIndices(indexFilePath);
+            uploadMesh();
+        }
     }
 
     // Destructor
     ~CurveWithTexture() {
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
+        lods.release();
     }
+    CurveWithTexture(const CurveWithTexture&) = delete;
+    CurveWithTexture& operator=(const CurveWithTexture&) = delete;
 
-    // Render the curve
-    void render(Shader& shader, const glm::mat4& model, const glm::vec3& viewPos) {
+    // Render the curve; lodLevel (per drawn instance) enables level of detail
+    void render(Shader& shader, const glm::mat4& model, int* lodLevel = nullptr) {
         shader.use();
 
-        // Pass transformation matrices
-        shader.setMat4("model", model);
-
-        // Pass material properties
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseTexture);
-        shader.setInt("material.diffuse", 0);
-
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, specularTexture);
-        shader.setInt("material.specular", 1);
+        // Pass transformation matrix and material
+        DrawUniforms::instance().push(model, material);
 
-        shader.setFloat("material.shininess", shininess);
+        // Bind textures
+        bindMaterialTextures(shader, diffuseTexture, specularTexture);
 
-        // Pass view position for lighting calculations
-        shader.setVec3("viewPos", viewPos);
+        // the view position for lighting comes from the frame uniform block
 
-        // Bind VAO and render
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        // Render from the shared geometry arena
+        GeometryArena::instance().draw(LodSelector::instance().choose(lods, model, lodLevel));
     }
 
+    MaterialId material;    // entry of the surface colours in the material table (materialTable.h)
+
 private:
-    unsigned int VAO, VBO, EBO;
+    LodChain lods;          // ranges in the shared geometry arena: the mesh, then simplified levels
     unsigned int diffuseTexture, specularTexture;
     float shininess;
 
     std::vector<float> vertices;  // x, y, z, nx, ny, nz, u, v
     std::vector<unsigned int> indices;
 
+    // Maps a baked container and uploads straight from the mapping; false when there is none
+    bool loadContainer(const std::string& containerPath) {
+        MeshContainer container;
+        if (!container.open(containerPath))
+            return false;
+        buildSimplifiedLodChain(lods, "CurveWithTexture", container.vertices(), container.vertexCount(), container.floatsPerVertex(),
+            container.indices(), container.indexCount());
+        return true;
+    }
+
     // Load vertices from a file
     void loadVertices(const std::string& filePath) {
-        std::ifstream file(filePath);
-        if (!file.is_open()) {
+        if (!parseNumberFile(filePath, 8, vertices))
             std::cerr << "Error: Unable to open vertices file: " << filePath << std::endl;
-            return;
-        }
-
-        float x, y, z, nx, ny, nz, u, v;
-        while (file >> x >> y >> z >> nx >> ny >> nz >> u >> v) {
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-            vertices.push_back(nx);
-            vertices.push_back(ny);
-            vertices.push_back(nz);
-            vertices.push_back(u);
-            vertices.push_back(v);
-        }
-        file.close();
     }
 
     // Load indices from a file
     void loadIndices(const std::string& filePath) {
-        std::ifstream file(filePath);
-        if (!file.is_open()) {
+        if (!parseNumberFile(filePath, 3, indices))
             std::cerr << "Error: Unable to open indices file: " << filePath << std::endl;
-            return;
-        }
-
-        unsigned int i1, i2, i3;
-        while (file >> i1 >> i2 >> i3) {
-            indices.push_back(i1);
-            indices.push_back(i2);
-            indices.push_back(i3);
-        }
-        file.close();
     }
 
-    // Set up VAO, VBO, and EBO
-    void setupVAO() {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-
-        // Load vertex data into VBO
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-        // Load index data into EBO
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-        // Configure vertex attributes
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0); // Position
-        glEnableVertexAttribArray(0);
-
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float))); // Normal
-        glEnableVertexAttribArray(1);
-
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float))); // Texture coordinates
-        glEnableVertexAttribArray(2);
-
-        glBindVertexArray(0);
+    // Copies the vertices and indices, with quadric-simplified levels, into the shared geometry arena
+    void uploadMesh() {
+        buildSimplifiedLodChain(lods, "CurveWithTexture", vertices.data(), vertices.size() / 8, 8, indices.data(), indices.size());
     }
 };
 
@@ -0,0 +1,111 @@
+//
+//  assetPrefetcher.h
+//
+
+//
+
+#ifndef assetPrefetcher_h
+#define assetPrefetcher_h
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <iostream>
+#include "textureCache.h"
+
+// one texture a later part of the game will ask loadTexture() for
+struct PrefetchAsset
+{
+    const char* path;
+    GLint wrapS;
+    GLint wrapT;
+    GLint minFilter;
+    GLint magFilter;
+};
+
+// Requests the textures of upcoming rooms while the current one is still being played, so
+// their decode runs on the loader threads and their upload is spread over ordinary frames
+// by the cache's time-sliced pumpUploads(). When the room really starts, loadTexture() hits
+// the cache and the transition only swaps texture names. Anything not ready by then samples
+// the cache's placeholder texel until it arrives.
+class AssetPrefetcher
+{
+public:
+    static AssetPrefetcher& instance()
+    {
+        static AssetPrefetcher prefetcher;
+        return prefetcher;
+    }
+
+    // starts loading a stage's textures in the background and files them under the room that
+    // uses them, so the cache's residency can release them when that room is left; GL thread only
+    void prefetch(const char* stage, int room, const std::vector<PrefetchAsset>& assets)
+    {
+        TextureCache& cache = TextureCache::instance();
+        for (const PrefetchAsset& asset : assets)
+        {
+            // the same view loadTexture() will ask for, so its sampler object exists up front too
+            unsigned int view = cache.acquireView(asset.path, asset.wrapS, asset.wrapT, asset.minFilter, asset.magFilter);
+            handles.push_back(cache.imageOf(view));
+            cache.assignRoom(handles.back(), room);
+        }
+        std::cout << "Prefetching " << assets.size() << " texture views for " << stage << std::endl;
+    }
+
+    // prefetched textures still waiting for their decode or upload
+    int pendingCount() const
+    {
+        int pending = 0;
+        for (const TextureHandle& handle : handles)
+            if (!handle->ready)
+                ++pending;
+        return pending;
+    }
+
+    // marks the frame that switches rooms; it and the following few frames are checked against the budget
+    void beginTransition(const char* name)
+    {
+        transitionName = name;
+        transitionFramesLeft = TRANSITION_WATCH_FRAMES;
+        int pending = pendingCount();
+        if (pending > 0)
+            std::cout << "Transition to " << name << ": " << pending << " textures not ready, showing placeholders" << std::endl;
+    }
+
+    // called once per frame with the duration of the frame that just finished
+    void frameFinished(double frameMs)
+    {
+        if (transitionFramesLeft == 0)
+            return;
+        int frame = TRANSITION_WATCH_FRAMES - transitionFramesLeft;
+        --transitionFramesLeft;
+        if (frameMs > frameBudgetMs)
+            std::cout << "Transition to " << transitionName << ": frame " << frame << " took " << frameMs
+                << " ms (budget " << frameBudgetMs << " ms)" << std::endl;
+    }
+
+    void setFrameBudget(double ms)
+    {
+        frameBudgetMs = ms;
+    }
+
+    // drops the prefetch handles; must run before the cache is cleared
+    void release()
+    {
+        handles.clear();
+    }
+
+private:
+    static const int TRANSITION_WATCH_FRAMES = 8;
+
+    std::vector<TextureHandle> handles;     // images of the prefetched views; views of one file share an entry
+    std::string transitionName;
+    int transitionFramesLeft = 0;
+    double frameBudgetMs = 20.0;            // a 60 Hz frame plus some slack
+
+    AssetPrefetcher() {}
+    AssetPrefetcher(const AssetPrefetcher&) = delete;
+    AssetPrefetcher& operator=(const AssetPrefetcher&) = delete;
+};
+
+#endif /* assetPrefetcher_h */
@@ -0,0 +1,221 @@
+//
+//  boxGeometry.h
+//
+
+//
+
+#ifndef boxGeometry_h
+#define boxGeometry_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <iostream>
+#include "shader.h"
+#include "geometryArena.h"
+
+// the box variants with their own vertex data
+enum class BoxShape
+{
+    Box,            // every face textured 0..1: Cube, Chest and the room cube in main.cpp
+    LeftFaceBox,    // only the left face textured: LeftFaceTexturedCube
+    Count
+};
+
+// Flyweight geometry of the unit box [0, 1]^3. Each shape is copied into the geometry arena the
+// first time an instance asks for it and shared by all later ones, so a hundred crates cost one
+// mesh. What differs per instance (material, texture range) is set as uniforms when drawing.
+class BoxGeometry
+{
+public:
+    // faces in the order front (-z), right, back, left, top, bottom; 6 indices each
+    static const GLuint INDICES_PER_FACE = 6;
+
+    static BoxGeometry& instance()
+    {
+        static BoxGeometry geometry;
+        return geometry;
+    }
+
+    // mesh of the shape, built on first use; pair each call with release() in the destructor
+    const ArenaMesh& acquire(BoxShape shape)
+    {
+        Entry& entry = entries[(int)shape];
+        if (!entry.mesh.valid())
+            build(shape, entry);
+        ++entry.users;
+        return entry.mesh;
+    }
+
+    // only counts instances; the mesh stays until clear()
+    void release(BoxShape shape)
+    {
+        Entry& entry = entries[(int)shape];
+        if (entry.users > 0)
+            --entry.users;
+    }
+
+    void printStats() const
+    {
+        std::cout << "Box geometry:";
+        for (int i = 0; i < (int)BoxShape::Count; ++i)
+        {
+            const Entry& entry = entries[i];
+            std::cout << " " << shapeName((BoxShape)i) << " " << (entry.mesh.valid() ? 1 : 0) << " mesh for " << entry.users << " instances"
+                << (i + 1 < (int)BoxShape::Count ? "," : "");
+        }
+        std::cout << std::endl;
+    }
+
+    // must run while the GL context is still current
+    void clear()
+    {
+        for (Entry& entry : entries)
+            GeometryArena::instance().release(entry.mesh);
+    }
+
+private:
+    struct Entry
+    {
+        ArenaMesh mesh;
+        size_t users = 0;
+    };
+
+    Entry entries[(int)BoxShape::Count];
+
+    static const char* shapeName(BoxShape shape)
+    {
+        return shape == BoxShape::Box ? "box" : "left face box";
+    }
+
+    void build(BoxShape shape, Entry& entry)
+    {
+        static const unsigned int indices[] = {
+            0, 3, 2,
+            2, 1, 0,
+
+            4, 5, 7,
+            7, 6, 4,
+
+            8, 9, 10,
+            10, 11, 8,
+
+            12, 13, 14,
+            14, 15, 12,
+
+            16, 17, 18,
+            18, 19, 16,
+
+            20, 21, 22,
+            22, 23, 20
+        };
+
+        if (shape == BoxShape::Box)
+        {
+            static const float vertices[] = {
+                // positions      // normals         // texture
+                0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f,
+                1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f,
+                1.0f, 1.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f,
+                0.0f, 1.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f,
+
+                1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+                1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
+                1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+                1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+
+                0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+                1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f,
+                1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f,
+                0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f,
+
+                0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+                0.0f, 1.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f,
+                0.0f, 1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+                0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+
+                1.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f,
+                1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f,
+                0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,
+                0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f,
+
+                0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+                1.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f,
+                1.0f, 0.0f, 1.0f, 0.0f, -1.0f, 0.0f, 1.0f, 1.0f,
+                0.0f, 0.0f, 1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f
+            };
+            // the chest draws its front face separately, so it stays a range of its own
+            static const std::vector<size_t> frontFace = { INDICES_PER_FACE };
+            entry.mesh = GeometryArena::instance().allocate(vertices, 24, 8, indices, 36, "Box", &frontFace);
+        }
+        else
+        {
+            static const float vertices[] = {
+                // front face
+                0.0f, 0.0f, 0.0f,  0.0f, 0.0f, -1.0f,  0.0f, 0.0f,
+                1.0f, 0.0f, 0.0f,  0.0f, 0.0f, -1.0f,  0.0f, 0.0f,
+                1.0f, 1.0f, 0.0f,  0.0f, 0.0f, -1.0f,  0.0f, 0.0f,
+                0.0f, 1.0f, 0.0f,  0.0f, 0.0f, -1.0f,  0.0f, 0.0f,
+
+                // back face
+                0.0f, 0.0f, 1.0f,  0.0f, 0.0f, 1.0f,  0.0f, 0.0f,
+                1.0f, 0.0f, 1.0f,  0.0f, 0.0f, 1.0f,  0.0f, 0.0f,
+                1.0f, 1.0f, 1.0f,  0.0f, 0.0f, 1.0f,  0.0f, 0.0f,
+                0.0f, 1.0f, 1.0f,  0.0f, 0.0f, 1.0f,  0.0f, 0.0f,
+
+                // left face, the only textured one
+                0.0f, 0.0f, 1.0f,  -1.0f, 0.0f, 0.0f,  1.0f, 0.0f,
+                0.0f, 1.0f, 1.0f,  -1.0f, 0.0f, 0.0f,  1.0f, 1.0f,
+                0.0f, 1.0f, 0.0f,  -1.0f, 0.0f, 0.0f,  0.0f, 1.0f,
+                0.0f, 0.0f, 0.0f,  -1.0f, 0.0f, 0.0f,  0.0f, 0.0f,
+
+                // right face
+                1.0f, 0.0f, 1.0f,  1.0f, 0.0f, 0.0f,  0.0f, 0.0f,
+                1.0f, 1.0f, 1.0f,  1.0f, 0.0f, 0.0f,  0.0f, 1.0f,
+                1.0f, 1.0f, 0.0f,  1.0f, 0.0f, 0.0f,  0.0f, 1.0f,
+                1.0f, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f,  0.0f, 0.0f,
+
+                // top face
+                0.0f, 1.0f, 0.0f,  0.0f, 1.0f, 0.0f,  0.0f, 0.0f,
+                1.0f, 1.0f, 0.0f,  0.0f, 1.0f, 0.0f,  0.0f, 0.0f,
+                1.0f, 1.0f, 1.0f,  0.0f, 1.0f, 0.0f,  0.0f, 0.0f,
+                0.0f, 1.0f, 1.0f,  0.0f, 1.0f, 0.0f,  0.0f, 0.0f,
+
+                // bottom face
+                0.0f, 0.0f, 0.0f,  0.0f, -1.0f, 0.0f,  0.0f, 0.0f,
+                1.0f, 0.0f, 0.0f,  0.0f, -1.0f, 0.0f,  0.0f, 0.0f,
+                1.0f, 0.0f, 1.0f,  0.0f, -1.0f, 0.0f,  0.0f, 0.0f,
+                0.0f, 0.0f, 1.0f,  0.0f, -1.0f, 0.0f,  0.0f, 0.0f,
+            };
+            static const unsigned int leftFaceIndices[] = {
+                0, 1, 2, 2, 3, 0,
+                4, 5, 6, 6, 7, 4,
+                8, 9, 10, 10, 11, 8,
+                12, 13, 14, 14, 15, 12,
+                16, 17, 18, 18, 19, 16,
+                20, 21, 22, 22, 23, 20
+            };
+            entry.mesh = GeometryArena::instance().allocate(vertices, 24, 8, leftFaceIndices, 36, "LeftFaceBox");
+        }
+    }
+
+    BoxGeometry() {}
+    BoxGeometry(const BoxGeometry&) = delete;
+    BoxGeometry& operator=(const BoxGeometry&) = delete;
+};
+
+// Maps the box's 0..1 texture coordinates to [xMin, xMax] x [yMin, yMax] in the textured vertex
+// shaders. The uniform stays set on the program, so draws with a range reset it afterwards.
+inline bool setTextureRange(Shader& shader, float xMin, float yMin, float xMax, float yMax)
+{
+    bool identity = xMin == 0.0f && yMin == 0.0f && xMax == 1.0f && yMax == 1.0f;
+    if (!identity)
+        shader.setVec4("texRange", glm::vec4(xMin, yMin, xMax - xMin, yMax - yMin));
+    return !identity;
+}
+
+inline void resetTextureRange(Shader& shader)
+{
+    shader.setVec4("texRange", glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+}
+
+#endif /* boxGeometry_h */
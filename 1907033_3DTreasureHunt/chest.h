@@ -1,13 +1,22 @@
+#ifndef chest_h
+#define chest_h
+
+#include "textureArray.h"
+#include "geometryArena.h"
+#include "drawUniforms.h"
+#include "boxGeometry.h"
+
 class Chest {
 public:
     glm::vec3 ambient;
     glm::vec3 diffuseColor; // Material surface diffuse color
     glm::vec3 specularColor; // Material surface specular color
     float shininess;
+    MaterialId material = MaterialTable::DEFAULT;  // entry of the colours above in the material table (materialTable.h)
 
     // Texture properties
-    unsigned int frontTexture;
-    unsigned int otherTexture;
+    unsigned int frontTexture = 0;
+    unsigned int otherTexture = 0;
 
     // Common properties
     //float shininess;
@@ -18,13 +27,13 @@ public:
     float TYmax = 1.0f;
 
     // Constructors
-    Chest() {
-        setUpCubeVertexDataAndConfigureVertexAttribute();
+    Chest() : mesh(BoxGeometry::instance().acquire(BoxShape::Box)) {
     }
 
     
 
     Chest(glm::vec3 amb, glm::vec3 diff, glm::vec3 spec, unsigned int frontTex, unsigned int otherTex, float shiny)
+        : mesh(BoxGeometry::instance().acquire(BoxShape::Box))
     {
         this->ambient = amb;
         this->diffuseColor = diff;
@@ -34,128 +43,59 @@ public:
         this->frontTexture = frontTex;
         this->otherTexture = otherTex;
         this->shininess = shiny;
-
-        setUpCubeVertexDataAndConfigureVertexAttribute();
+        material = MaterialTable::instance().add(ambient, diffuseColor, specularColor, shininess);
     }
 
-    // Destructor
     ~Chest() {
-        glDeleteVertexArrays(1, &cubeVAO);
-        glDeleteBuffers(1, &cubeVBO);
-        glDeleteBuffers(1, &cubeEBO);
+        BoxGeometry::instance().release(BoxShape::Box);
     }
+    Chest(const Chest&) = delete;
+    Chest& operator=(const Chest&) = delete;
 
     // Draw the cube with two textures and blending
-    void drawCubeWithTwoTextures(Shader& shader, glm::mat4 model = glm::mat4(1.0f)) {
-        shader.use();
-
-        // Pass material properties
-        shader.setVec3("material.ambient", this->ambient);
-        shader.setVec3("material.diffuseColor", this->diffuseColor); // Surface diffuse color
-        shader.setVec3("material.specularColor", this->specularColor); // Surface specular color
-        shader.setFloat("material.shininess", this->shininess);
-
-        // Pass texture units
-        shader.setInt("material.diffuse", 0);  // Texture unit 0 for diffuse
-        shader.setInt("material.specular", 1); // Texture unit 1 for specular
-
-        shader.setMat4("model", model);
-
-        glBindVertexArray(cubeVAO);
+    void drawCubeWithTwoTextures(Shader& shader, glm::mat4 model = glm::mat4(1.0f)) const {
+        drawCubeWithTwoTextures(shader, model, material, frontTexture, otherTexture);
+    }
 
-        // Draw the front face with its texture
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, this->frontTexture);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    // one draw with its own material and textures, so a shared chest (see meshRegistry.h)
+    // serves objects of any look without being changed
+    void drawCubeWithTwoTextures(Shader& shader, glm::mat4 model, MaterialId drawMaterial, unsigned int frontTex, unsigned int otherTex) const {
+        shader.use();
 
-        // Draw the other faces with their texture
-        glBindTexture(GL_TEXTURE_2D, this->otherTexture);
-        glDrawElements(GL_TRIANGLES, 30, GL_UNSIGNED_INT, (void*)(6 * sizeof(unsigned int)));
+        DrawUniforms::instance().push(model, drawMaterial);
+
+        bool ranged = setTextureRange(shader, TXmin, TYmin, TXmax, TYmax);
+        GeometryArena& arena = GeometryArena::instance();
+
+        // both textures packed in the texture array: one draw, the shaders pick the front (-z)
+        // face's layer or the others' per face; faceLayers is reset so later draws ignore it
+        int frontLayer = MaterialTextureArray::instance().layerOf(frontTex);
+        int otherLayer = MaterialTextureArray::instance().layerOf(otherTex);
+        if (frontLayer >= 0 && otherLayer >= 0) {
+            shader.setBool("useTextureArray", true);
+            shader.setVec2("faceLayers", glm::vec2((float)frontLayer, (float)otherLayer));
+            arena.draw(mesh);
+            shader.setVec2("faceLayers", glm::vec2(-1.0f));
+        }
+        else {
+            // the front face is the first of the shared box, so each texture is one index range
+            shader.setBool("useTextureArray", false);
+
+            // Draw the front face with its texture
+            TextureCache::instance().bind(0, frontTex);
+            arena.drawRange(mesh, 0, BoxGeometry::INDICES_PER_FACE);
+
+            // Draw the other faces with their texture
+            TextureCache::instance().bind(0, otherTex);
+            arena.drawRange(mesh, BoxGeometry::INDICES_PER_FACE, 5 * BoxGeometry::INDICES_PER_FACE);
+        }
+
+        if (ranged)
+            resetTextureRange(shader);
     }
 
 private:
-    unsigned int cubeVAO, cubeVBO, cubeEBO;
-
-    void setUpCubeVertexDataAndConfigureVertexAttribute() {
-        float cube_vertices[] = {
-            // positions         // normals          // texture coords
-            // Front face (with different texture)
-           0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, TXmax, TYmin,
-            1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, TXmin, TYmin,
-            1.0f, 1.0f, 0.0f, 0.0f, 0.0f, -1.0f, TXmin, TYmax,
-            0.0f, 1.0f, 0.0f, 0.0f, 0.0f, -1.0f, TXmax, TYmax,
-
-            // Other faces
-            1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, TXmax, TYmin,
-            1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, TXmax, TYmax,
-            1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, TXmin, TYmin,
-            1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, TXmin, TYmax,
-
-            0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, TXmin, TYmin,
-            1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, TXmax, TYmin,
-            1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, TXmax, TYmax,
-            0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, TXmin, TYmax,
-
-            0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, TXmax, TYmin,
-            0.0f, 1.0f, 1.0f, -1.0f, 0.0f, 0.0f, TXmax, TYmax,
-            0.0f, 1.0f, 0.0f, -1.0f, 0.0f, 0.0f, TXmin, TYmax,
-            0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, TXmin, TYmin,
-
-            1.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, TXmax, TYmin,
-            1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, TXmax, TYmax,
-            0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, TXmin, TYmax,
-            0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, TXmin, TYmin,
-
-            0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, TXmin, TYmin,
-            1.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, TXmax, TYmin,
-            1.0f, 0.0f, 1.0f, 0.0f, -1.0f, 0.0f, TXmax, TYmax,
-            0.0f, 0.0f, 1.0f, 0.0f, -1.0f, 0.0f, TXmin, TYmax
-        };
-
-        unsigned int cube_indices[] = {
-            0, 3, 2,
-            2, 1, 0,
-
-            4, 5, 7,
-            7, 6, 4,
-
-            8, 9, 10,
-            10, 11, 8,
-
-            12, 13, 14,
-            14, 15, 12,
-
-            16, 17, 18,
-            18, 19, 16,
-
-            20, 21, 22,
-            22, 23, 20
-        };
-
-        glGenVertexArrays(1, &cubeVAO);
-        glGenBuffers(1, &cubeVBO);
-        glGenBuffers(1, &cubeEBO);
-
-        glBindVertexArray(cubeVAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeEBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cube_indices), cube_indices, GL_STATIC_DRAW);
-
-        // Position attribute
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        // Normal attribute
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-
-        // Texture coordinate attribute
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-        glEnableVertexAttribArray(2);
-
-        glBindVertexArray(0);
-    }
+    const ArenaMesh& mesh;  // the unit box shared with every cube (boxGeometry.h)
 };
+
+#endif /* chest_h */
@@ -9,16 +9,20 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "shader.h"
+#include "geometryArena.h"
+#include "drawUniforms.h"
+#include "boxGeometry.h"
+#include "textureArray.h"
 
 using namespace std;
 
 class Cube {
 public:
 
-    // materialistic property
-    glm::vec3 ambient;
-    glm::vec3 diffuse;
-    glm::vec3 specular;
+    // materialistic property; the textured draws blend their maps with these colours too
+    glm::vec3 ambient = glm::vec3(0.2f);
+    glm::vec3 diffuse = glm::vec3(0.8f);
+    glm::vec3 specular = glm::vec3(1.0f);
 
     // texture property
     float TXmin = 0.0f;
@@ -29,25 +33,26 @@ public:
     unsigned int specularMap;
 
     // common property
-    float shininess;
+    float shininess = 32.0f;
+    MaterialId material = MaterialTable::DEFAULT;  // entry of the colours above in the material table (materialTable.h)
 
     // constructors
-    Cube()
+    Cube() : mesh(BoxGeometry::instance().acquire(BoxShape::Box))
     {
-        setUpCubeVertexDataAndConfigureVertexAttribute();
+        material = MaterialTable::instance().add(ambient, diffuse, specular, shininess);
     }
 
-    Cube(glm::vec3 amb, glm::vec3 diff, glm::vec3 spec, float shiny)
+    Cube(glm::vec3 amb, glm::vec3 diff, glm::vec3 spec, float shiny) : mesh(BoxGeometry::instance().acquire(BoxShape::Box))
     {
         this->ambient = amb;
         this->diffuse = diff;
         this->specular = spec;
         this->shininess = shiny;
-
-        setUpCubeVertexDataAndConfigureVertexAttribute();
+        material = MaterialTable::instance().add(ambient, diffuse, specular, shininess);
     }
 
     Cube(unsigned int dMap, unsigned int sMap, float shiny, float textureXmin, float textureYmin, float textureXmax, float textureYmax)
+        : mesh(BoxGeometry::instance().acquire(BoxShape::Box))
     {
         this->diffuseMap = dMap;
         this->specularMap = sMap;
@@ -56,8 +61,7 @@ public:
         this->TYmin = textureYmin;
         this->TXmax = textureXmax;
         this->TYmax = textureYmax;
-
-        setUpCubeVertexDataAndConfigureVertexAttribute();
+        material = MaterialTable::instance().add(ambient, diffuse, specular, shininess);
     }
 
 
@@ -66,48 +70,33 @@ public:
     // destructor
     ~Cube()
     {
-        glDeleteVertexArrays(1, &cubeVAO);
-        glDeleteVertexArrays(1, &lightCubeVAO);
-        glDeleteVertexArrays(1, &lightTexCubeVAO);
-        glDeleteBuffers(1, &cubeVBO);
-        glDeleteBuffers(1, &cubeEBO);
+        BoxGeometry::instance().release(BoxShape::Box);
     }
+    Cube(const Cube&) = delete;
+    Cube& operator=(const Cube&) = delete;
 
     void drawCubeWithTexture(Shader& lightingShaderWithTexture, glm::mat4 model = glm::mat4(1.0f))
     {
         lightingShaderWithTexture.use();
 
-        lightingShaderWithTexture.setInt("material.diffuse", 0);
-        lightingShaderWithTexture.setInt("material.specular", 1);
-        lightingShaderWithTexture.setFloat("material.shininess", this->shininess);
-
+        // bind diffuse and specular maps (or select the diffuse layer of the texture array)
+        bindMaterialTextures(lightingShaderWithTexture, this->diffuseMap, this->specularMap);
 
-        // bind diffuse map
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, this->diffuseMap);
-        // bind specular map
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, this->specularMap);
+        DrawUniforms::instance().push(model, material);
 
-        lightingShaderWithTexture.setMat4("model", model);
-
-        glBindVertexArray(lightTexCubeVAO);
-        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+        bool ranged = setTextureRange(lightingShaderWithTexture, TXmin, TYmin, TXmax, TYmax);
+        GeometryArena::instance().draw(mesh);
+        if (ranged)
+            resetTextureRange(lightingShaderWithTexture);
     }
 
     void drawCubeWithMaterialisticProperty(Shader& lightingShader, glm::mat4 model = glm::mat4(1.0f))
     {
         lightingShader.use();
 
-        lightingShader.setVec3("material.ambient", this->ambient);
-        lightingShader.setVec3("material.diffuse", this->diffuse);
-        lightingShader.setVec3("material.specular", this->specular);
-        lightingShader.setFloat("material.shininess", this->shininess);
-
-        lightingShader.setMat4("model", model);
+        DrawUniforms::instance().push(model, material);
 
-        glBindVertexArray(lightCubeVAO);
-        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+        GeometryArena::instance().draw(mesh);
     }
 
     void drawCube(Shader& shader, glm::mat4 model = glm::mat4(1.0f), float r = 1.0f, float g = 1.0f, float b = 1.0f)
@@ -115,10 +104,9 @@ public:
         shader.use();
 
         shader.setVec3("color", glm::vec3(r, g, b));
-        shader.setMat4("model", model);
+        DrawUniforms::instance().push(model);
 
-        glBindVertexArray(cubeVAO);
-        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+        GeometryArena::instance().draw(mesh);
     }
 
     void setMaterialisticProperty(glm::vec3 amb, glm::vec3 diff, glm::vec3 spec, float shiny)
@@ -127,6 +115,7 @@ public:
         this->diffuse = diff;
         this->specular = spec;
         this->shininess = shiny;
+        material = MaterialTable::instance().add(ambient, diffuse, specular, shininess);
     }
 
     void setTextureProperty(unsigned int dMap, unsigned int sMap, float shiny)
@@ -134,120 +123,11 @@ public:
         this->diffuseMap = dMap;
         this->specularMap = sMap;
         this->shininess = shiny;
+        material = MaterialTable::instance().add(ambient, diffuse, specular, shininess);
     }
 
 private:
-    unsigned int cubeVAO;
-    unsigned int lightCubeVAO;
-    unsigned int lightTexCubeVAO;
-    unsigned int cubeVBO;
-    unsigned int cubeEBO;
-
-    void setUpCubeVertexDataAndConfigureVertexAttribute()
-    {
-        // set up vertex data (and buffer(s)) and configure vertex attributes
-        // ------------------------------------------------------------------
-
-        float cube_vertices[] = {
-            // positions      // normals         // texture
-            0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, TXmax, TYmin,
-            1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, TXmin, TYmin,
-            1.0f, 1.0f, 0.0f, 0.0f, 0.0f, -1.0f, TXmin, TYmax,
-            0.0f, 1.0f, 0.0f, 0.0f, 0.0f, -1.0f, TXmax, TYmax,
-
-            1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, TXmax, TYmin,
-            1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, TXmax, TYmax,
-            1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, TXmin, TYmin,
-            1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, TXmin, TYmax,
-
-            0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, TXmin, TYmin,
-            1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, TXmax, TYmin,
-            1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, TXmax, TYmax,
-            0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, TXmin, TYmax,
-
-            0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, TXmax, TYmin,
-            0.0f, 1.0f, 1.0f, -1.0f, 0.0f, 0.0f, TXmax, TYmax,
-            0.0f, 1.0f, 0.0f, -1.0f, 0.0f, 0.0f, TXmin, TYmax,
-            0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, TXmin, TYmin,
-
-            1.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, TXmax, TYmin,
-            1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, TXmax, TYmax,
-            0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, TXmin, TYmax,
-            0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, TXmin, TYmin,
-
-            0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, TXmin, TYmin,
-            1.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, TXmax, TYmin,
-            1.0f, 0.0f, 1.0f, 0.0f, -1.0f, 0.0f, TXmax, TYmax,
-            0.0f, 0.0f, 1.0f, 0.0f, -1.0f, 0.0f, TXmin, TYmax
-        };
-        unsigned int cube_indices[] = {
-            0, 3, 2,
-            2, 1, 0,
-
-            4, 5, 7,
-            7, 6, 4,
-
-            8, 9, 10,
-            10, 11, 8,
-
-            12, 13, 14,
-            14, 15, 12,
-
-            16, 17, 18,
-            18, 19, 16,
-
-            20, 21, 22,
-            22, 23, 20
-        };
-
-        glGenVertexArrays(1, &cubeVAO);
-        glGenVertexArrays(1, &lightCubeVAO);
-        glGenVertexArrays(1, &lightTexCubeVAO);
-        glGenBuffers(1, &cubeVBO);
-        glGenBuffers(1, &cubeEBO);
-
-
-        glBindVertexArray(lightTexCubeVAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeEBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cube_indices), cube_indices, GL_STATIC_DRAW);
-
-        // position attribute
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        // vertex normal attribute
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)12);
-        glEnableVertexAttribArray(1);
-
-        // texture coordinate attribute
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)24);
-        glEnableVertexAttribArray(2);
-
-
-        glBindVertexArray(lightCubeVAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeEBO);
-
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)12);
-        glEnableVertexAttribArray(1);
-
-
-        glBindVertexArray(cubeVAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeEBO);
-
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-    }
+    const ArenaMesh& mesh;  // the unit box shared by every cube (boxGeometry.h)
 
 };
 
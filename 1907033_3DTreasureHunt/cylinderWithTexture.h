@@ -7,8 +7,12 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "shader.h"
-
-#define PI 3.1416
+#include "geometryArena.h"
+#include "drawUniforms.h"
+#include "lod.h"
+#include "revolution.h"
+#include "textureArray.h"
+#include "tessellatedSurfaces.h"
 
 using namespace std;
 
@@ -18,6 +22,7 @@ public:
     glm::vec3 diffuse;
     glm::vec3 specular;
     float shininess;
+    MaterialId material = MaterialTable::DEFAULT;  // entry of the colours above in the material table (materialTable.h)
 
     // Texture maps
     unsigned int diffuseMap;
@@ -31,52 +36,54 @@ public:
         unsigned int diffuseTexture = 0, unsigned int specularTexture = 0)
         : verticesStride(32), diffuseMap(diffuseTexture), specularMap(specularTexture) {
         set(baseRadius, topRadius, height, sectorCount, stackCount, amb, diff, spec, shiny);
-        buildCoordinatesAndIndices();
-        buildVertices();
-        setupVAO();
+        buildMesh();
+        uploadMesh();
     }
 
     ~CylinderWithTexture() {
-        glDeleteVertexArrays(1, &cylinderVAO);
+        lods.release();
     }
+    CylinderWithTexture(const CylinderWithTexture&) = delete;
+    CylinderWithTexture& operator=(const CylinderWithTexture&) = delete;
 
-    void drawCylinder(Shader& lightingShader, glm::mat4 model, glm::vec3 viewPos) const {
-        lightingShader.use();
-
-        // Pass material properties
-        lightingShader.setVec3("material.ambient", ambient);
-        lightingShader.setVec3("material.diffuseColor", diffuse);
-        lightingShader.setVec3("material.specularColor", specular);
-        lightingShader.setFloat("material.shininess", shininess);
+    // lodLevel (per drawn instance) enables level of detail
+    void drawCylinder(Shader& shader, glm::mat4 model, int* lodLevel = nullptr) const {
+        drawCylinder(shader, model, material, diffuseMap, specularMap, lodLevel);
+    }
 
-        // Pass texture units
-        lightingShader.setInt("material.diffuse", 0);
-        lightingShader.setInt("material.specular", 1);
+    // one draw with its own material and maps, so a shared mesh (see meshRegistry.h) serves
+    // objects of any look without being changed
+    void drawCylinder(Shader& shader, glm::mat4 model, MaterialId drawMaterial, unsigned int diffuseTexture,
+        unsigned int specularTexture, int* lodLevel = nullptr) const {
+        // on GPUs that tessellate, the tessellation program stands in for the lit textured shaders
+        Shader* tessellated = TessellatedSurfaces::instance().replacement(shader);
+        Shader& lightingShader = tessellated ? *tessellated : shader;
+        lightingShader.use();
 
         // Bind textures
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, specularMap);
+        bindMaterialTextures(lightingShader, diffuseTexture, specularTexture);
 
-        // Set transformation matrices
-        lightingShader.setMat4("model", model);
-        lightingShader.setVec3("viewPos", viewPos);
+        // Model matrix and material of this draw
+        DrawUniforms::instance().push(model, drawMaterial);
 
         // Draw the cylinder
-        glBindVertexArray(cylinderVAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        if (tessellated) {
+            TessellatedSurfaces& surfaces = TessellatedSurfaces::instance();
+            surfaces.drawFrustum(baseRadius, topRadius, height);
+            if (topRadius > 0.0f)
+                surfaces.drawDisk(topRadius, height / 2, true);
+            if (baseRadius > 0.0f)
+                surfaces.drawDisk(baseRadius, -height / 2, false);
+        }
+        else
+            GeometryArena::instance().draw(LodSelector::instance().choose(lods, model, lodLevel));
     }
 
 private:
-    unsigned int cylinderVAO;
+    LodChain lods;              // ranges in the shared geometry arena, finest first
     float baseRadius, topRadius, height;
     int sectorCount, stackCount;
     vector<float> vertices;
-    vector<float> normals;
-    vector<float> texCoords;
-    vector<float> coordinates;
     vector<unsigned int> indices;
     int verticesStride;
 
@@ -91,159 +98,28 @@ private:
         this->diffuse = diff;
         this->specular = spec;
         this->shininess = shiny;
+        material = MaterialTable::instance().add(ambient, diffuse, specular, shininess);
     }
 
-    void buildCoordinatesAndIndices() {
-        float sectorStep = 2 * PI / sectorCount;
-        float stackStep = height / stackCount;
-        float sectorAngle;
-
-        // Generate coordinates
-        for (int i = 0; i <= stackCount; ++i) {
-            float y = -height / 2 + i * stackStep;
-            float radius = baseRadius + (topRadius - baseRadius) * i / stackCount;
-
-            for (int j = 0; j <= sectorCount; ++j) {
-                sectorAngle = j * sectorStep;
-                float x = radius * cosf(sectorAngle);
-                float z = radius * sinf(sectorAngle);
-
-                // Position
-                coordinates.push_back(x);
-                coordinates.push_back(y);
-                coordinates.push_back(z);
-
-                // Normal
-                glm::vec3 normal = glm::normalize(glm::vec3(x, 0.0f, z));
-                normals.push_back(normal.x);
-                normals.push_back(normal.y);
-                normals.push_back(normal.z);
-
-                // Texture coordinates
-                texCoords.push_back((float)j / sectorCount);
-                texCoords.push_back((float)i / stackCount);
-            }
-        }
-
-        // Generate indices
-        int k1, k2;
-        for (int i = 0; i < stackCount; ++i) {
-            k1 = i * (sectorCount + 1);
-            k2 = k1 + sectorCount + 1;
-
-            for (int j = 0; j < sectorCount; ++j, ++k1, ++k2) {
-                indices.push_back(k1);
-                indices.push_back(k2);
-                indices.push_back(k1 + 1);
-
-                indices.push_back(k1 + 1);
-                indices.push_back(k2);
-                indices.push_back(k2 + 1);
-            }
-        }
+    void buildMesh() {
+        build(sectorCount, stackCount, vertices, indices);
+    }
 
-        // Generate caps
+    void build(int sectors, int stacks, vector<float>& outVertices, vector<unsigned int>& outIndices) const {
+        RevolutionCap caps[2];
+        int capCount = 0;
         if (topRadius > 0.0f)
-            buildCap(topRadius, height / 2, true);
+            caps[capCount++] = { topRadius, height / 2, true };
         if (baseRadius > 0.0f)
-            buildCap(baseRadius, -height / 2, false);
+            caps[capCount++] = { baseRadius, -height / 2, false };
+        buildRevolutionSpecialized<true>(FrustumProfile(baseRadius, topRadius, height, stacks), sectors,
+            0.0f, (float)(2 * PI), caps, capCount, outVertices, outIndices);
     }
 
-    void buildCap(float radius, float y, bool isTop) {
-        float sectorStep = 2 * PI / sectorCount;
-        float sectorAngle;
-
-        int centerIndex = coordinates.size() / 3;
-        coordinates.push_back(0.0f);
-        coordinates.push_back(y);
-        coordinates.push_back(0.0f);
-
-        normals.push_back(0.0f);
-        normals.push_back(isTop ? 1.0f : -1.0f);
-        normals.push_back(0.0f);
-
-        texCoords.push_back(0.5f);
-        texCoords.push_back(0.5f);
-
-        for (int j = 0; j <= sectorCount; ++j) {
-            sectorAngle = j * sectorStep;
-            float x = radius * cosf(sectorAngle);
-            float z = radius * sinf(sectorAngle);
-
-            coordinates.push_back(x);
-            coordinates.push_back(y);
-            coordinates.push_back(z);
-
-            normals.push_back(0.0f);
-            normals.push_back(isTop ? 1.0f : -1.0f);
-            normals.push_back(0.0f);
-
-            texCoords.push_back((x / radius + 1.0f) * 0.5f);
-            texCoords.push_back((z / radius + 1.0f) * 0.5f);
-
-            if (j < sectorCount) {
-                if (isTop) {
-                    indices.push_back(centerIndex);
-                    indices.push_back(centerIndex + j + 1);
-                    indices.push_back(centerIndex + j + 2);
-                }
-                else {
-                    indices.push_back(centerIndex);
-                    indices.push_back(centerIndex + j + 2);
-                    indices.push_back(centerIndex + j + 1);
-                }
-            }
-        }
-    }
-
-    void buildVertices() {
-        vertices.clear();
-        size_t vertexCount = coordinates.size() / 3;
-        for (size_t i = 0; i < vertexCount; ++i) {
-            // Position
-            vertices.push_back(coordinates[i * 3]);
-            vertices.push_back(coordinates[i * 3 + 1]);
-            vertices.push_back(coordinates[i * 3 + 2]);
-
-            // Normal
-            vertices.push_back(normals[i * 3]);
-            vertices.push_back(normals[i * 3 + 1]);
-            vertices.push_back(normals[i * 3 + 2]);
-
-            // Texture coordinates
-            vertices.push_back(texCoords[i * 2]);
-            vertices.push_back(texCoords[i * 2 + 1]);
-        }
-    }
-
-    void setupVAO() {
-        glGenVertexArrays(1, &cylinderVAO);
-        glBindVertexArray(cylinderVAO);
-
-        // Create VBO
-        unsigned int cylinderVBO;
-        glGenBuffers(1, &cylinderVBO);
-        glBindBuffer(GL_ARRAY_BUFFER, cylinderVBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
-
-        // Create EBO
-        unsigned int cylinderEBO;
-        glGenBuffers(1, &cylinderEBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cylinderEBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // Configure vertex attributes
-        int stride = verticesStride;
-        glEnableVertexAttribArray(0); // Position
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
-
-        glEnableVertexAttribArray(1); // Normal
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
-
-        glEnableVertexAttribArray(2); // Texture coordinates
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
-
-        glBindVertexArray(0);
+    // Copies the vertices and indices, and coarser tessellations down to 8 sectors, into the shared geometry arena
+    void uploadMesh() {
+        buildLodChain(lods, "CylinderWithTexture", vertices, indices, sectorCount, stackCount, 8, 1,
+            [this](int sectors, int stacks, vector<float>& v, vector<unsigned int>& i) { build(sectors, stacks, v, i); });
     }
 };
 
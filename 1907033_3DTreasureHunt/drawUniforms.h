@@ -0,0 +1,419 @@
+//
+//  drawUniforms.h
+//
+
+//
+
+#ifndef drawUniforms_h
+#define drawUniforms_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <iostream>
+#include "shader.h"
+#include "glHandle.h"
+#include "materialTable.h"
+
+// GL 4.4 / ARB_buffer_storage names the core 3.3 glad headers lack
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+// The DrawData uniform block, declared the same way in every lighting shader:
+//
+//     layout (std140) uniform DrawData
+//     {
+//         mat4 model;
+//         mat3 normalMatrix;
+//         ivec4 material;
+//     } draw;
+//
+// std140 stores a mat3 as three vec4 columns, so every member is vec4-sized and the offsets
+// are the C++ ones.
+struct DrawData
+{
+    glm::mat4 model;
+    glm::vec4 normalMatrix[3];  // columns of the inverse transpose of the model's upper 3x3; w unused
+    glm::ivec4 material;        // x = MaterialTable index
+};
+
+static_assert(sizeof(DrawData) == 128, "DrawData must match the std140 block");
+
+// Matrix taking object-space normals to world space. When the columns of the upper 3x3 are
+// orthogonal and of equal length s (rotations, mirrors and uniform scales, which is nearly
+// every draw here) the inverse transpose is that 3x3 divided by s^2; anything else (the
+// squashed boxes of the furniture) takes the full inverse. fast, if given, reports the path.
+inline glm::mat3 normalMatrixOf(const glm::mat4& model, bool* fast = nullptr)
+{
+    glm::mat3 linear(model);
+    float xx = glm::dot(linear[0], linear[0]);
+    float tolerance = 1e-5f * xx;
+    bool similarity = xx > 0.0f
+        && fabsf(glm::dot(linear[1], linear[1]) - xx) <= tolerance
+        && fabsf(glm::dot(linear[2], linear[2]) - xx) <= tolerance
+        && fabsf(glm::dot(linear[0], linear[1])) <= tolerance
+        && fabsf(glm::dot(linear[0], linear[2])) <= tolerance
+        && fabsf(glm::dot(linear[1], linear[2])) <= tolerance;
+    if (fast)
+        *fast = similarity;
+    if (similarity)
+        return linear * (1.0f / xx);
+    return glm::transpose(glm::inverse(linear));
+}
+
+// where a draw's DrawData was written; valid until the end of the frame
+struct DrawSlot
+{
+    GLuint buffer = 0;
+    GLintptr offset = 0;
+
+    bool operator==(const DrawSlot& other) const
+    {
+        return buffer == other.buffer && offset == other.offset;
+    }
+    bool operator!=(const DrawSlot& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// Per-draw uniforms streamed through one uniform buffer. Each draw's DrawData is written to
+// the next free slot of this frame's region and bound with glBindBufferRange, so the model
+// matrix, its normal matrix and the material are not uniforms of any program: switching
+// programs or blending modes sends nothing again. Lists of draws (DrawBatch) write all their
+// slots at once, which is how the rooms, objects and targets are drawn.
+//
+// Slots are written straight into the buffer without the driver synchronising: through one
+// persistent mapping of the whole buffer when the context has buffer storage (GL 4.4 or
+// ARB_buffer_storage), otherwise through a glMapBufferRange of the written slots with
+// GL_MAP_UNSYNCHRONIZED_BIT, since a 3.3 buffer cannot be drawn from while it stays mapped.
+// Either way nothing stops the CPU overwriting a slot the GPU has not read yet except the
+// fences: the buffer holds FRAMES regions used in turn, and the fence placed at the end of
+// each frame is waited on before its region is written again, which only blocks when the GPU
+// is more than FRAMES - 1 frames behind. A region that fills up moves the frame to a buffer
+// twice the size; the old one stays alive until the frame ends, for slots already handed out.
+// GL thread only.
+class DrawUniforms
+{
+public:
+    static const GLuint BINDING = 1;    // FrameUniforms uses 0
+    static const int FRAMES = 3;
+
+    static DrawUniforms& instance()
+    {
+        static DrawUniforms uniforms;
+        return uniforms;
+    }
+
+    // Sizes the slots for the context's offset alignment, fetches glBufferStorage through
+    // load when the context has it and creates the buffer; once, after the glad loader.
+    void init(GLADloadproc load, size_t drawsPerFrame = 1024)
+    {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        stride = (sizeof(DrawData) + alignment - 1) / alignment * alignment;
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        if (major > 4 || (major == 4 && minor >= 4) || hasExtension("GL_ARB_buffer_storage"))
+            bufferStorage = (BufferStorageProc)load("glBufferStorage");
+        allocate(drawsPerFrame);
+    }
+
+    // points the shader's DrawData block, if it has one, at BINDING
+    static void attach(const Shader& shader)
+    {
+        GLuint index = glGetUniformBlockIndex(shader.ID, "DrawData");
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(shader.ID, index, BINDING);
+    }
+
+    // before the frame's first draw: moves to the next region, waiting for the GPU to finish
+    // reading it if it has not yet, as the writes that follow do not
+    void beginFrame()
+    {
+        region = (region + 1) % FRAMES;
+        used = 0;
+        bound = DrawSlot();     // the first draw of the frame writes a slot of its own
+        GLsync& fence = fences[region];
+        if (fence)
+        {
+            GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            if (status == GL_TIMEOUT_EXPIRED)
+            {
+                ++stalls;
+                while (status == GL_TIMEOUT_EXPIRED)
+                    status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+            }
+            glDeleteSync(fence);
+            fence = 0;
+        }
+    }
+
+    // Writes count consecutive DrawData into this frame's region and returns the first slot;
+    // bind them with bind() before the draws that use them.
+    DrawSlot write(const DrawData* data, size_t count)
+    {
+        if (count == 0)
+            return DrawSlot();
+        if (used + count > capacity)
+            grow(used + count);
+
+        DrawSlot slot;
+        slot.buffer = buffer;
+        slot.offset = (GLintptr)((region * capacity + used) * stride);
+        GLsizeiptr bytes = (GLsizeiptr)(count * stride);
+        if (mapped)
+        {
+            copySlots(mapped + slot.offset, data, count);
+        }
+        else
+        {
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+            void* target = glMapBufferRange(GL_UNIFORM_BUFFER, slot.offset, bytes,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (target)
+            {
+                copySlots((unsigned char*)target, data, count);
+                glUnmapBuffer(GL_UNIFORM_BUFFER);
+            }
+            else
+            {
+                // the driver refused the mapping; an ordinary (synchronised) upload still works
+                staging.resize(bytes);
+                copySlots(staging.data(), data, count);
+                glBufferSubData(GL_UNIFORM_BUFFER, slot.offset, bytes, staging.data());
+            }
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+        used += count;
+        ++uploadsThisFrame;
+        slotsThisFrame += count;
+        return slot;
+    }
+
+    // slot i of a write() that returned first
+    DrawSlot slotAt(DrawSlot first, size_t i) const
+    {
+        first.offset += (GLintptr)(i * stride);
+        return first;
+    }
+
+    // makes slot, which holds data, the DrawData of the following draws
+    void bind(DrawSlot slot, const DrawData& data)
+    {
+        boundData = data;
+        if (slot == bound)
+            return;
+        glBindBufferRange(GL_UNIFORM_BUFFER, BINDING, slot.buffer, slot.offset, sizeof(DrawData));
+        bound = slot;
+        ++bindsThisFrame;
+    }
+
+    // one draw's DrawData: written and bound, unless the bound slot already holds it
+    void push(const DrawData& data)
+    {
+        if (bound.buffer != 0 && memcmp(&boundData, &data, sizeof(DrawData)) == 0)
+        {
+            ++reusedThisFrame;
+            return;
+        }
+        bind(write(&data, 1), data);
+    }
+
+    // the normal matrix is only worked out when the bound slot holds another draw
+    void push(const glm::mat4& model, MaterialId material = MaterialTable::DEFAULT)
+    {
+        if (bound.buffer != 0 && boundData.material.x == material && memcmp(&boundData.model, &model, sizeof(glm::mat4)) == 0)
+        {
+            ++reusedThisFrame;
+            return;
+        }
+        push(drawData(model, material));
+    }
+
+    // a draw's DrawData, with its normal matrix computed here once instead of per vertex
+    DrawData drawData(const glm::mat4& model, MaterialId material)
+    {
+        bool fast = false;
+        glm::mat3 normal = normalMatrixOf(model, &fast);
+        ++(fast ? fastNormalsThisFrame : invertedNormalsThisFrame);
+        DrawData data;
+        data.model = model;
+        for (int i = 0; i < 3; ++i)
+            data.normalMatrix[i] = glm::vec4(normal[i], 0.0f);
+        data.material = glm::ivec4(material, 0, 0, 0);
+        return data;
+    }
+
+    // after the frame's last draw: fences the region and retires buffers replaced by grow()
+    void endFrame()
+    {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        if (!retired.empty())
+            bound = DrawSlot();     // the names may come back for new buffers
+        retired.clear();
+        lastFrameUploads = uploadsThisFrame;
+        lastFrameSlots = slotsThisFrame;
+        lastFrameBinds = bindsThisFrame;
+        lastFrameReused = reusedThisFrame;
+        lastFrameFastNormals = fastNormalsThisFrame;
+        lastFrameInvertedNormals = invertedNormalsThisFrame;
+        uploadsThisFrame = slotsThisFrame = bindsThisFrame = reusedThisFrame = 0;
+        fastNormalsThisFrame = invertedNormalsThisFrame = 0;
+    }
+
+    void printStats() const
+    {
+        std::cout << "Draw uniforms: " << lastFrameSlots << " slots in " << lastFrameUploads
+            << (mapped ? " writes to the persistent mapping, " : " unsynchronized mapped writes, ")
+            << lastFrameBinds << " range binds, " << lastFrameReused << " draws reusing the bound slot last frame; " << capacity << " slots of " << stride
+            << " bytes per frame region, " << stalls << " fence waits" << std::endl;
+        std::cout << "Normal matrices: " << lastFrameFastNormals << " by scaling (rigid or uniform scale), "
+            << lastFrameInvertedNormals << " by inverse last frame" << std::endl;
+    }
+
+    // must run while the GL context is still current
+    void release()
+    {
+        for (GLsync& fence : fences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+            fence = 0;
+        }
+        retired.clear();
+        mapped = nullptr;       // deleting the buffer unmaps it
+        buffer.reset();
+        bound = DrawSlot();
+    }
+
+private:
+    typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+    BufferStorageProc bufferStorage = nullptr;
+    GLBuffer buffer;
+    unsigned char* mapped = nullptr;    // the persistent mapping of buffer, if there is one
+    std::vector<GLBuffer> retired;      // replaced this frame; slots in them are still bound
+    GLsync fences[FRAMES] = {};
+    size_t stride = 256;
+    size_t capacity = 0;                // slots per region
+    int region = 0;
+    size_t used = 0;                    // slots written in this frame's region
+    std::vector<unsigned char> staging;     // only when a mapping fails
+    DrawSlot bound;
+    DrawData boundData = {};
+    unsigned long long uploadsThisFrame = 0, slotsThisFrame = 0, bindsThisFrame = 0, reusedThisFrame = 0;
+    unsigned long long lastFrameUploads = 0, lastFrameSlots = 0, lastFrameBinds = 0, lastFrameReused = 0;
+    unsigned long long fastNormalsThisFrame = 0, invertedNormalsThisFrame = 0;
+    unsigned long long lastFrameFastNormals = 0, lastFrameInvertedNormals = 0;
+    unsigned long long stalls = 0;
+
+    static bool hasExtension(const char* wanted)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i)
+        {
+            const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (name && strcmp(name, wanted) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    void copySlots(unsigned char* target, const DrawData* data, size_t count) const
+    {
+        for (size_t i = 0; i < count; ++i)
+            memcpy(target + i * stride, &data[i], sizeof(DrawData));
+    }
+
+    // With buffer storage the buffer is immutable and mapped once for its whole life;
+    // otherwise it is an ordinary GL_STREAM_DRAW buffer mapped per write.
+    void allocate(size_t slots)
+    {
+        capacity = slots;
+        GLsizeiptr bytes = (GLsizeiptr)(FRAMES * capacity * stride);
+        buffer = GLBuffer::create(GL_HERE);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        mapped = nullptr;
+        if (bufferStorage)
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            bufferStorage(GL_UNIFORM_BUFFER, bytes, nullptr, flags);
+            mapped = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, bytes, flags);
+            if (!mapped)
+            {
+                std::cout << "Draw uniforms: persistent mapping failed, mapping per write instead" << std::endl;
+                bufferStorage = nullptr;
+                glBindBuffer(GL_UNIFORM_BUFFER, 0);
+                allocate(slots);
+                return;
+            }
+        }
+        else
+        {
+            glBufferData(GL_UNIFORM_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        }
+        buffer.setBytes(bytes);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // The frame goes on in a new buffer with room for at least needed slots. Nothing has
+    // been written to it, so no region needs waiting for.
+    void grow(size_t needed)
+    {
+        size_t slots = capacity * 2;
+        while (slots < needed)
+            slots *= 2;
+        std::cout << "Draw uniforms: " << needed << " draws in a frame, growing to " << slots << " slots per region" << std::endl;
+        retired.push_back(std::move(buffer));
+        for (GLsync& fence : fences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+            fence = 0;
+        }
+        allocate(slots);
+        used = 0;
+    }
+
+    DrawUniforms() {}
+    DrawUniforms(const DrawUniforms&) = delete;
+    DrawUniforms& operator=(const DrawUniforms&) = delete;
+};
+
+// DrawData of a list of draws known before the first of them, e.g. every object of a room:
+// written in one go, then bind(i) before draw i. A primitive's own push() of the same
+// values reuses the bound slot.
+class DrawBatch
+{
+public:
+    void add(const glm::mat4& model, MaterialId material = MaterialTable::DEFAULT)
+    {
+        data.push_back(DrawUniforms::instance().drawData(model, material));
+    }
+
+    void write()
+    {
+        first = DrawUniforms::instance().write(data.data(), data.size());
+    }
+
+    void bind(size_t i) const
+    {
+        DrawUniforms& uniforms = DrawUniforms::instance();
+        uniforms.bind(uniforms.slotAt(first, i), data[i]);
+    }
+
+private:
+    std::vector<DrawData> data;
+    DrawSlot first;
+};
+
+#endif /* drawUniforms_h */
@@ -57,16 +57,66 @@ struct SpotLight {
 in vec3 FragPos;
 in vec3 Normal;
 
-uniform vec3 viewPos;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
+struct FramePointLight {
+    vec4 position;  // xyz; w = 1 when the light is on
+    vec4 ambient;   // rgb; w = k_c
+    vec4 diffuse;   // rgb; w = k_l
+    vec4 specular;  // rgb; w = k_q
+};
+
+// camera and point lights, written once per frame and shared by every lighting program (frameUniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    FramePointLight lights[2];
+} frame;
 uniform SpotLight spotLight;
-uniform Material material;
+// the model matrix and material of the draw, in a slot of the streaming per-draw buffer (drawUniforms.h)
+layout (std140) uniform DrawData
+{
+    mat4 model;
+    mat3 normalMatrix; // inverse transpose of model's upper 3x3, worked out once per draw on the CPU
+    ivec4 material; // x = index into the material table
+} draw;
+
+struct MaterialData {
+    vec4 ambient;   // rgb; w = shininess
+    vec4 diffuse;
+    vec4 specular;
+    vec4 emissive;
+};
+
+// every registered material, written once (materialTable.h)
+layout (std140) uniform MaterialTable
+{
+    MaterialData materials[256];
+};
+Material material; // set from drawMaterial() first thing in main()
 uniform DiectionalLight diectionalLight;
 uniform bool dlighton = true;
 uniform float time; // Time for flickering effect
 
 //uniform bool spotlighton = true;
 
+// point light i of the frame block in this shader's PointLight form; the flicker is already in the colours
+PointLight pointLight(int i)
+{
+    FramePointLight l = frame.lights[i];
+    PointLight light;
+    light.position = l.position.xyz;
+    light.k_c = l.ambient.w;
+    light.k_l = l.diffuse.w;
+    light.k_q = l.specular.w;
+    light.ambient = l.ambient.rgb;
+    light.diffuse = l.diffuse.rgb;
+    light.specular = l.specular.rgb;
+    light.isFlickering = false;
+    light.flickerIntensity = 0.0;
+    return light;
+}
+
 
 
 // function prototypes
@@ -75,17 +125,31 @@ vec3 CalcDirectionalLight(Material material, DiectionalLight light, vec3 N, vec3
 vec3 CalcSpotLight(Material material, SpotLight light, vec3 N, vec3 fragPos, vec3 V);
 
 
+// this draw's entry of the material table in this shader's Material form
+Material drawMaterial()
+{
+    MaterialData m = materials[draw.material.x];
+    Material material;
+    material.ambient = m.ambient.rgb;
+    material.diffuse = m.diffuse.rgb;
+    material.specular = m.specular.rgb;
+    material.emissive = m.emissive.rgb;
+    material.shininess = m.ambient.w;
+    return material;
+}
+
 void main()
 {
+    material = drawMaterial();
     //FragColor = vec4(0.0, 0.0, 0.0, 1.0);
     // properties
     vec3 N = normalize(Normal);
-    vec3 V = normalize(viewPos - FragPos);
+    vec3 V = normalize(frame.viewPos.xyz - FragPos);
     
     vec3 result;
     // point lights
     for(int i = 0; i < NR_POINT_LIGHTS; i++)
-        result += CalcPointLight(material, pointLights[i], N, FragPos, V,i);
+        result += CalcPointLight(material, pointLight(i), N, FragPos, V,i);
     
     result += CalcDirectionalLight(material, diectionalLight, N, V);
     result += CalcSpotLight(material, spotLight, N, FragPos, V);
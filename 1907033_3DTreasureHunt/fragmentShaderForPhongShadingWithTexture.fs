@@ -2,8 +2,6 @@
 out vec4 FragColor;
 
 struct Material {
-    sampler2D diffuse;
-    sampler2D specular;
     vec3 ambient; // Material surface ambient color
     vec3 diffuseColor; // Material surface diffuse color
     vec3 specularColor; // Material surface specular color
@@ -30,39 +28,120 @@ in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
-uniform vec3 viewPos;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform bool pointLightEnabled[NR_POINT_LIGHTS]; // Light state toggles
-uniform Material material;
+struct FramePointLight {
+    vec4 position;  // xyz; w = 1 when the light is on
+    vec4 ambient;   // rgb; w = k_c
+    vec4 diffuse;   // rgb; w = k_l
+    vec4 specular;  // rgb; w = k_q
+};
+
+// camera and point lights, written once per frame and shared by every lighting program (frameUniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    FramePointLight lights[2];
+} frame;
+// the model matrix and material of the draw, in a slot of the streaming per-draw buffer (drawUniforms.h)
+layout (std140) uniform DrawData
+{
+    mat4 model;
+    mat3 normalMatrix; // inverse transpose of model's upper 3x3, worked out once per draw on the CPU
+    ivec4 material; // x = index into the material table
+} draw;
+
+struct MaterialData {
+    vec4 ambient;   // rgb; w = shininess
+    vec4 diffuse;
+    vec4 specular;
+    vec4 emissive;
+};
+
+// every registered material, written once (materialTable.h)
+layout (std140) uniform MaterialTable
+{
+    MaterialData materials[256];
+};
+uniform sampler2D diffuseMap;  // texture unit 0
+uniform sampler2D specularMap; // texture unit 1
+Material material; // set from drawMaterial() first thing in main()
 uniform bool enableBlending; // New uniform to toggle blending
 uniform float time; // Time for flickering effect
+uniform bool useTextureArray; // diffuse comes from a layer of materialLayers instead of diffuseMap
+uniform sampler2DArray materialLayers;
+uniform float diffuseLayer;
+uniform vec2 faceLayers = vec2(-1.0); // a two-texture box (chest.h): layers of its front (-z) face and of the others; x < 0 otherwise
 
 
 // Function prototypes
 vec3 CalcPointLight(Material material, PointLight light, bool isEnabled, vec3 N, vec3 fragPos, vec3 V);
 
+// point light i of the frame block in this shader's PointLight form; the flicker is already in the colours
+PointLight pointLight(int i)
+{
+    FramePointLight l = frame.lights[i];
+    PointLight light;
+    light.position = l.position.xyz;
+    light.k_c = l.ambient.w;
+    light.k_l = l.diffuse.w;
+    light.k_q = l.specular.w;
+    light.ambient = l.ambient.rgb;
+    light.diffuse = l.diffuse.rgb;
+    light.specular = l.specular.rgb;
+    light.isFlickering = false;
+    light.flickerIntensity = 0.0;
+    return light;
+}
+
+// light state toggle
+bool pointLightEnabled(int i)
+{
+    return frame.lights[i].position.w > 0.5;
+}
+
+
+// this draw's entry of the material table in this shader's Material form
+Material drawMaterial()
+{
+    MaterialData m = materials[draw.material.x];
+    Material material;
+    material.ambient = m.ambient.rgb;
+    material.diffuseColor = m.diffuse.rgb;
+    material.specularColor = m.specular.rgb;
+    material.shininess = m.ambient.w;
+    return material;
+}
 
 void main()
 {
+    material = drawMaterial();
     // Normalize properties
     vec3 N = normalize(Normal);
-    vec3 V = normalize(viewPos - FragPos);
+    vec3 V = normalize(frame.viewPos.xyz - FragPos);
 
     vec3 result = vec3(0.0); // Initialize lighting result
 
     // Add contributions from enabled point lights
     bool anyLightEnabled = false;
     for (int i = 0; i < NR_POINT_LIGHTS; i++) {
-        if (pointLightEnabled[i]) {
+        if (pointLightEnabled(i)) {
             anyLightEnabled = true;
-            result += CalcPointLight(material, pointLights[i], pointLightEnabled[i], N, FragPos, V);
+            result += CalcPointLight(material, pointLight(i), true, N, FragPos, V);
         }
 
     }
     
 
-    // Sample texture color
-    vec3 textureColor = vec3(texture(material.diffuse, TexCoords));
+    // Sample texture color; a chest picks its layer by whether the normal, taken back to the
+    // box's own axes, points down -z
+    float layer = diffuseLayer;
+    if (faceLayers.x >= 0.0) {
+        vec3 objectNormal = transpose(mat3(draw.model)) * N;
+        layer = objectNormal.z < -0.5 * length(objectNormal) ? faceLayers.x : faceLayers.y;
+    }
+    vec3 textureColor = useTextureArray ? vec3(texture(materialLayers, vec3(TexCoords, layer)))
+                                        : vec3(texture(diffuseMap, TexCoords));
 
     if (!anyLightEnabled) {
         // If no lights are enabled, make everything black
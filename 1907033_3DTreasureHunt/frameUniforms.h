@@ -0,0 +1,122 @@
+//
+//  frameUniforms.h
+//
+
+//
+
+#ifndef frameUniforms_h
+#define frameUniforms_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <iostream>
+#include "shader.h"
+#include "glHandle.h"
+
+#define FRAME_POINT_LIGHTS 2    // NR_POINT_LIGHTS in the shaders
+
+// One point light as the shaders' FrameData block lays it out (std140: four vec4s)
+struct FramePointLight
+{
+    glm::vec4 position;     // xyz; w = 1 when the light is on
+    glm::vec4 ambient;      // rgb; w = constant attenuation k_c
+    glm::vec4 diffuse;      // rgb; w = linear attenuation k_l
+    glm::vec4 specular;     // rgb; w = quadratic attenuation k_q
+};
+
+// The FrameData uniform block, declared the same way in every lighting shader:
+//
+//     layout (std140) uniform FrameData
+//     {
+//         mat4 projection;
+//         mat4 view;
+//         vec4 viewPos;
+//         FramePointLight lights[NR_POINT_LIGHTS];
+//     } frame;
+//
+// Only vec4 and mat4 members, so the std140 offsets are the C++ ones.
+struct FrameData
+{
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec4 viewPos;      // xyz
+    FramePointLight lights[FRAME_POINT_LIGHTS];
+};
+
+static_assert(sizeof(FrameData) == 2 * 64 + 16 + FRAME_POINT_LIGHTS * 64, "FrameData must match the std140 block");
+
+// Camera and point lights for the frame in one uniform buffer at a fixed binding point.
+// Every program attached here reads the same copy, so the values are written once per
+// frame however many programs (and blending modes) draw with them. GL thread only.
+class FrameUniforms
+{
+public:
+    static const GLuint BINDING = 0;
+
+    static FrameUniforms& instance()
+    {
+        static FrameUniforms uniforms;
+        return uniforms;
+    }
+
+    // the values upload() sends; fill them in before drawing
+    FrameData data = {};
+
+    // creates the buffer and binds it to BINDING; once, after the glad loader
+    void init()
+    {
+        buffer = GLBuffer::create(GL_HERE);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+        buffer.setBytes(sizeof(FrameData));
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, buffer);
+    }
+
+    // points the shader's FrameData block, if it has one, at BINDING
+    static void attach(const Shader& shader)
+    {
+        GLuint index = glGetUniformBlockIndex(shader.ID, "FrameData");
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(shader.ID, index, BINDING);
+    }
+
+    void setCamera(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& viewPos)
+    {
+        data.projection = projection;
+        data.view = view;
+        data.viewPos = glm::vec4(viewPos, 1.0f);
+    }
+
+    // The whole block in one write, orphaning last frame's storage so the driver need not
+    // wait for draws still reading it
+    void upload()
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), &data, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        ++uploads;
+    }
+
+    void printStats() const
+    {
+        std::cout << "Frame uniforms: " << sizeof(FrameData) << " bytes written " << uploads
+            << " times, once per frame, at binding " << BINDING << std::endl;
+    }
+
+    // must run while the GL context is still current
+    void release()
+    {
+        buffer.reset();
+    }
+
+private:
+    GLBuffer buffer;
+    unsigned long long uploads = 0;
+
+    FrameUniforms() {}
+    FrameUniforms(const FrameUniforms&) = delete;
+    FrameUniforms& operator=(const FrameUniforms&) = delete;
+};
+
+#endif /* frameUniforms_h */
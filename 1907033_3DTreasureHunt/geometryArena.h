@@ -0,0 +1,630 @@
+//
+//  geometryArena.h
+//
+
+//
+
+#ifndef geometryArena_h
+#define geometryArena_h
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <string>
+#include <iterator>
+#include <iostream>
+#include "vertexPacking.h"
+#include "meshOptimizer.h"
+#include "glHandle.h"
+
+// Where a mesh lives inside the arena: its vertices start at baseVertex and its (mesh local)
+// indices at index slot firstIndex, so it is drawn with glDrawElementsBaseVertex and no buffer
+// rebinding. Index slots are 4 bytes; a mesh of 16-bit indices packs two into each.
+// Owners release their range in the destructor and are not copyable, so no range is released twice.
+struct ArenaMesh
+{
+    GLint baseVertex = 0;
+    GLuint vertexCount = 0;
+    GLuint firstIndex = 0;
+    GLuint indexCount = 0;
+    GLuint indexOffset = 0;     // where the mesh starts inside its index block (see subMesh())
+    GLenum indexType = GL_UNSIGNED_INT;
+    int kind = -1;              // index into the arena's per-name statistics
+    bool sharedVertices = false;    // the blocks belong to an earlier mesh with the same contents
+    bool sharedIndices = false;
+
+    bool valid() const
+    {
+        return indexCount != 0;
+    }
+
+    size_t indexSize() const
+    {
+        return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+    }
+
+    GLuint indexSlots() const
+    {
+        return indexType == GL_UNSIGNED_SHORT ? (indexCount + 1) / 2 : indexCount;
+    }
+};
+
+// First-fit free list over a range of slots (vertices or indices). Freed blocks are merged
+// with their neighbours, so what stays scattered is the real fragmentation.
+class ArenaSpace
+{
+public:
+    size_t capacity() const
+    {
+        return total;
+    }
+
+    size_t used() const
+    {
+        return total - freeTotal;
+    }
+
+    size_t freeBlockCount() const
+    {
+        return freeBlocks.size();
+    }
+
+    size_t largestFreeBlock() const
+    {
+        size_t largest = 0;
+        for (auto& block : freeBlocks)
+            if (block.second > largest)
+                largest = block.second;
+        return largest;
+    }
+
+    // share of the free space that is not part of the largest free block (0 = one hole)
+    float fragmentation() const
+    {
+        return freeTotal == 0 ? 0.0f : 1.0f - (float)largestFreeBlock() / freeTotal;
+    }
+
+    bool allocate(size_t count, size_t& offset)
+    {
+        for (auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it)
+        {
+            if (it->second < count)
+                continue;
+            offset = it->first;
+            size_t left = it->second - count;
+            freeBlocks.erase(it);
+            if (left > 0)
+                freeBlocks[offset + count] = left;
+            freeTotal -= count;
+            return true;
+        }
+        return false;
+    }
+
+    void release(size_t offset, size_t count)
+    {
+        if (count == 0)
+            return;
+        freeTotal += count;
+        auto next = freeBlocks.lower_bound(offset);
+        if (next != freeBlocks.end() && offset + count == next->first)
+        {
+            count += next->second;
+            next = freeBlocks.erase(next);
+        }
+        if (next != freeBlocks.begin())
+        {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset)
+            {
+                previous->second += count;
+                return;
+            }
+        }
+        freeBlocks[offset] = count;
+    }
+
+    // the slots between the old and the new capacity become free
+    void grow(size_t newCapacity)
+    {
+        size_t added = newCapacity - total;
+        size_t offset = total;
+        total = newCapacity;
+        release(offset, added);
+    }
+
+    void reset()
+    {
+        freeBlocks.clear();
+        total = 0;
+        freeTotal = 0;
+    }
+
+private:
+    std::map<size_t, size_t> freeBlocks;    // offset -> length
+    size_t total = 0;
+    size_t freeTotal = 0;
+};
+
+// One vertex buffer, one index buffer and one VAO shared by every primitive. All meshes use
+// the same interleaved format (position, normal, uv; 8 floats, or the 16-byte PackedVertex
+// after setPackedVertices(true)), so switching meshes needs no VAO or buffer change and a
+// frame of primitives costs a single glBindVertexArray. Meshes of fewer than 65536 vertices
+// store 16-bit indices. Both buffers double in size when full; existing ranges keep their offsets.
+// Vertex and index blocks are content-hashed: a mesh whose final vertices or indices match a
+// live block byte for byte references that block instead of storing a copy, so meshes of the
+// same topology (every sphere of one sector and stack count) share one set of indices.
+class GeometryArena
+{
+public:
+    static const int FLOATS_PER_VERTEX = 8;
+
+    static GeometryArena& instance()
+    {
+        static GeometryArena arena;
+        return arena;
+    }
+
+    // Code that binds a VAO of its own (the trajectory line, the tessellation patches) calls
+    // this afterwards, so the next bind() does not take the arena's VAO for still bound.
+    void invalidateBinding()
+    {
+        currentVertexArray = 0;
+    }
+
+    // Chooses the vertex format. The buffers hold one format only, so this has to happen
+    // before the first mesh is allocated; later calls are refused.
+    bool setPackedVertices(bool enabled)
+    {
+        if (vao != 0 && enabled != packed)
+        {
+            std::cerr << "Geometry arena: vertex format can only change before the first mesh" << std::endl;
+            return false;
+        }
+        packed = enabled;
+        return true;
+    }
+
+    bool packedVertices() const
+    {
+        return packed;
+    }
+
+    // runs every mesh through MeshOptimizer before it is uploaded
+    void setOptimizeMeshes(bool enabled)
+    {
+        optimizing = enabled;
+    }
+
+    // Copies a mesh into the arena. Vertices with fewer than 8 floats (position and normal only)
+    // get zero texture coordinates. Indices are local to the mesh and only describe a triangle
+    // list as a whole: the optimizer may reorder triangles and vertices. splits lists index
+    // positions that start a new range for drawRange(); triangles never cross them. name groups
+    // the mesh in printStats(). GL thread only.
+    ArenaMesh allocate(const float* vertices, size_t vertexCount, int floatsPerVertex, const unsigned int* indices, size_t indexCount,
+        const char* name = "other", const std::vector<size_t>* splits = nullptr)
+    {
+        ArenaMesh mesh;
+        if (vertexCount == 0 || indexCount == 0)
+            return mesh;
+        if (!vao)
+            create();
+
+        std::vector<float> optimizedVertices;
+        std::vector<unsigned int> optimizedIndices;
+        if (optimizing)
+        {
+            optimizedVertices.assign(vertices, vertices + vertexCount * floatsPerVertex);
+            optimizedIndices.assign(indices, indices + indexCount);
+            MeshOptimizer::instance().optimize(optimizedVertices, floatsPerVertex, optimizedIndices, name, splits);
+            vertices = optimizedVertices.data();
+            vertexCount = optimizedVertices.size() / floatsPerVertex;
+            indices = optimizedIndices.data();
+            indexCount = optimizedIndices.size();
+        }
+
+        mesh.indexType = vertexCount < 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        mesh.indexCount = (GLuint)indexCount;
+
+        // the bytes that go into the buffers
+        std::vector<float> expanded;
+        std::vector<PackedVertex> packedVertices;
+        std::vector<uint16_t> shortIndices;
+        const void* vertexData = vertices;
+        const void* indexData = indices;
+        if (packed)
+        {
+            packVertices(vertices, vertexCount, floatsPerVertex, packedVertices);
+            vertexData = packedVertices.data();
+        }
+        else if (floatsPerVertex != FLOATS_PER_VERTEX)
+        {
+            expanded.assign(vertexCount * FLOATS_PER_VERTEX, 0.0f);
+            for (size_t i = 0; i < vertexCount; ++i)
+                for (int k = 0; k < floatsPerVertex && k < FLOATS_PER_VERTEX; ++k)
+                    expanded[i * FLOATS_PER_VERTEX + k] = vertices[i * floatsPerVertex + k];
+            vertexData = expanded.data();
+        }
+        if (mesh.indexType == GL_UNSIGNED_SHORT)
+        {
+            narrowIndices(indices, indexCount, shortIndices);
+            indexData = shortIndices.data();
+        }
+        size_t vertexSize = vertexBytes();
+        size_t vertexDataBytes = vertexCount * vertexSize;
+        size_t indexDataBytes = indexCount * mesh.indexSize();
+
+        // the copy targets leave the VAO's element buffer binding alone
+        size_t vertexOffset = 0, indexOffset = 0;
+        uint64_t vertexHash = hashBytes(vertexData, vertexDataBytes, 0);
+        mesh.sharedVertices = findBlock(vertexBlocks, vbo, vertexSize, vertexHash, vertexData, vertexDataBytes, vertexOffset);
+        if (!mesh.sharedVertices)
+        {
+            while (!vertexSpace.allocate(vertexCount, vertexOffset))
+                growVertices(vertexSpace.capacity() + vertexCount);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, vertexOffset * vertexSize, vertexDataBytes, vertexData);
+            addBlock(vertexBlocks, vertexOffset, vertexCount, vertexHash, vertexDataBytes);
+        }
+        uint64_t indexHash = hashBytes(indexData, indexDataBytes, mesh.indexType);
+        mesh.sharedIndices = findBlock(indexBlocks, ebo, INDEX_SLOT_SIZE, indexHash, indexData, indexDataBytes, indexOffset);
+        if (!mesh.sharedIndices)
+        {
+            while (!indexSpace.allocate(mesh.indexSlots(), indexOffset))
+                growIndices(indexSpace.capacity() + mesh.indexSlots());
+            glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset * INDEX_SLOT_SIZE, indexDataBytes, indexData);
+            addBlock(indexBlocks, indexOffset, mesh.indexSlots(), indexHash, indexDataBytes);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        if (mesh.sharedVertices || mesh.sharedIndices)
+        {
+            size_t saved = (mesh.sharedVertices ? vertexDataBytes : 0) + (mesh.sharedIndices ? indexDataBytes : 0);
+            std::cout << "Geometry arena: " << name << " reuses the " << (mesh.sharedVertices ? (mesh.sharedIndices ? "vertices and indices" : "vertices") : "indices")
+                << " of an earlier mesh, " << saved << " bytes deduplicated" << std::endl;
+            dedupedVertexBytes += mesh.sharedVertices ? vertexDataBytes : 0;
+            dedupedIndexBytes += mesh.sharedIndices ? indexDataBytes : 0;
+        }
+
+        mesh.baseVertex = (GLint)vertexOffset;
+        mesh.vertexCount = (GLuint)vertexCount;
+        mesh.firstIndex = (GLuint)indexOffset;
+        mesh.kind = kindOf(name);
+        account(mesh, 1);
+        ++meshCount;
+        return mesh;
+    }
+
+    // A mesh drawing indexCount indices of another, starting firstIndex indices into it, over
+    // the same vertices: a hemisphere as the upper half of a sphere. It holds its own
+    // references, so either can be released first. name groups it in printStats().
+    ArenaMesh subMesh(const ArenaMesh& mesh, GLuint firstIndex, GLuint indexCount, const char* name = "other")
+    {
+        ArenaMesh sub;
+        if (!mesh.valid() || !vao || firstIndex + indexCount > mesh.indexCount)
+            return sub;
+        sub = mesh;
+        sub.indexOffset = mesh.indexOffset + firstIndex;
+        sub.indexCount = indexCount;
+        sub.sharedVertices = true;
+        sub.sharedIndices = true;
+        sub.kind = kindOf(name);
+        ++vertexBlocks[mesh.baseVertex].references;
+        ++indexBlocks[mesh.firstIndex].references;
+        account(sub, 1);
+        ++meshCount;
+        return sub;
+    }
+
+    // returns the mesh's ranges to the free lists once no other mesh references them; safe after clear()
+    void release(ArenaMesh& mesh)
+    {
+        if (!mesh.valid())
+            return;
+        if (vao)
+        {
+            releaseBlock(vertexBlocks, vertexSpace, mesh.baseVertex);
+            releaseBlock(indexBlocks, indexSpace, mesh.firstIndex);
+            account(mesh, -1);
+            --meshCount;
+        }
+        mesh = ArenaMesh();
+    }
+
+    // binds the arena's VAO unless the last bind() left it bound
+    void bind()
+    {
+        if (currentVertexArray == vao)
+            return;
+        glBindVertexArray(vao);
+        currentVertexArray = vao;
+        ++bindsThisFrame;
+    }
+
+    void draw(const ArenaMesh& mesh, GLenum mode = GL_TRIANGLES)
+    {
+        drawRange(mesh, 0, mesh.indexCount, mode);
+    }
+
+    // indexCount indices starting firstIndex indices into the mesh
+    void drawRange(const ArenaMesh& mesh, GLuint firstIndex, GLuint indexCount, GLenum mode = GL_TRIANGLES)
+    {
+        if (!mesh.valid())
+            return;
+        bind();
+        glDrawElementsBaseVertex(mode, indexCount, mesh.indexType,
+            (void*)(mesh.firstIndex * INDEX_SLOT_SIZE + (mesh.indexOffset + firstIndex) * mesh.indexSize()), mesh.baseVertex);
+    }
+
+    // call once per frame; remembers how many VAO binds the frame made
+    void endFrame()
+    {
+        lastFrameBinds = bindsThisFrame;
+        bindsThisFrame = 0;
+    }
+
+    void printStats() const
+    {
+        std::cout << "Geometry arena: " << meshCount << " meshes, " << (packed ? "packed 16-byte" : "32-byte float")
+            << " vertices" << std::endl;
+        printSpace("vertices", vertexSpace, vertexBytes());
+        printSpace("index slots", indexSpace, INDEX_SLOT_SIZE);
+
+        // what each kind of mesh takes against 8-float vertices and 32-bit indices
+        size_t totalBytes = 0, totalUnpacked = 0;
+        for (const KindStats& kind : kinds)
+        {
+            if (kind.meshes == 0)
+                continue;
+            std::cout << "  " << kind.name << ": " << kind.meshes << " meshes, " << kind.bytes / 1024 << " KB instead of "
+                << kind.unpackedBytes / 1024 << " KB (" << savedPercent(kind.bytes, kind.unpackedBytes) << "% saved)" << std::endl;
+            totalBytes += kind.bytes;
+            totalUnpacked += kind.unpackedBytes;
+        }
+        std::cout << "  all meshes: " << totalBytes / 1024 << " KB instead of " << totalUnpacked / 1024 << " KB ("
+            << savedPercent(totalBytes, totalUnpacked) << "% saved)" << std::endl;
+        std::cout << "  deduplicated at load: " << dedupedVertexBytes / 1024 << " KB of vertices, " << dedupedIndexBytes / 1024
+            << " KB of indices; " << vertexBlocks.size() << " vertex and " << indexBlocks.size() << " index blocks live" << std::endl;
+        std::cout << "  VAO binds last frame: " << lastFrameBinds << std::endl;
+    }
+
+    // must run while the GL context is still current
+    void clear()
+    {
+        if (!vao)
+            return;
+        if (currentVertexArray == vao)      // a bound VAO reverts to 0 when deleted
+            currentVertexArray = 0;
+        vao.reset();
+        vbo.reset();
+        ebo.reset();
+        vertexSpace.reset();
+        indexSpace.reset();
+        vertexBlocks.clear();
+        indexBlocks.clear();
+        meshCount = 0;
+        for (KindStats& kind : kinds)
+            kind.meshes = kind.bytes = kind.unpackedBytes = 0;
+    }
+
+private:
+    static const size_t VERTEX_SIZE = FLOATS_PER_VERTEX * sizeof(float);
+    static const size_t INDEX_SLOT_SIZE = sizeof(unsigned int);
+    static const size_t INITIAL_VERTICES = 1 << 16;     // 2 MB, 1 MB packed
+    static const size_t INITIAL_INDICES = 1 << 18;      // 1 MB
+
+    // a stored vertex or index range and the meshes referencing it
+    struct Block
+    {
+        size_t slots = 0;           // vertices or index slots
+        size_t bytes = 0;           // bytes actually written
+        uint64_t hash = 0;
+        unsigned int references = 0;
+    };
+    typedef std::unordered_map<size_t, Block> BlockMap;     // offset -> block
+
+    struct KindStats
+    {
+        std::string name;
+        size_t meshes = 0;
+        size_t bytes = 0;
+        size_t unpackedBytes = 0;
+    };
+
+    GLVertexArray vao;
+    GLBuffer vbo, ebo;
+    ArenaSpace vertexSpace;
+    ArenaSpace indexSpace;
+    BlockMap vertexBlocks;
+    BlockMap indexBlocks;
+    size_t dedupedVertexBytes = 0;
+    size_t dedupedIndexBytes = 0;
+    size_t meshCount = 0;
+    std::vector<KindStats> kinds;
+    bool packed = false;
+    bool optimizing = false;
+    GLuint currentVertexArray = 0;      // what bind() last bound; 0 after invalidateBinding()
+    unsigned long long bindsThisFrame = 0;
+    unsigned long long lastFrameBinds = 0;
+
+    void create()
+    {
+        vao = GLVertexArray::create(GL_HERE);
+        vbo = GLBuffer::create(GL_HERE);
+        ebo = GLBuffer::create(GL_HERE);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+        glBufferData(GL_COPY_WRITE_BUFFER, INITIAL_VERTICES * vertexBytes(), NULL, GL_STATIC_DRAW);
+        vbo.setBytes(INITIAL_VERTICES * vertexBytes());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+        glBufferData(GL_COPY_WRITE_BUFFER, INITIAL_INDICES * INDEX_SLOT_SIZE, NULL, GL_STATIC_DRAW);
+        ebo.setBytes(INITIAL_INDICES * INDEX_SLOT_SIZE);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        vertexSpace.grow(INITIAL_VERTICES);
+        indexSpace.grow(INITIAL_INDICES);
+        setUpVertexArray();
+    }
+
+    size_t vertexBytes() const
+    {
+        return packed ? sizeof(PackedVertex) : VERTEX_SIZE;
+    }
+
+    int kindOf(const char* name)
+    {
+        for (size_t i = 0; i < kinds.size(); ++i)
+            if (kinds[i].name == name)
+                return (int)i;
+        kinds.push_back(KindStats());
+        kinds.back().name = name;
+        return (int)kinds.size() - 1;
+    }
+
+    // adds (sign 1) or removes (sign -1) a mesh from its kind's totals
+    void account(const ArenaMesh& mesh, int sign)
+    {
+        if (mesh.kind < 0 || mesh.kind >= (int)kinds.size())
+            return;
+        KindStats& kind = kinds[mesh.kind];
+        size_t bytes = (mesh.sharedVertices ? 0 : mesh.vertexCount * vertexBytes()) + (mesh.sharedIndices ? 0 : mesh.indexSlots() * INDEX_SLOT_SIZE);
+        size_t unpackedBytes = mesh.vertexCount * VERTEX_SIZE + mesh.indexCount * sizeof(unsigned int);
+        if (sign > 0)
+        {
+            ++kind.meshes;
+            kind.bytes += bytes;
+            kind.unpackedBytes += unpackedBytes;
+        }
+        else
+        {
+            --kind.meshes;
+            kind.bytes -= bytes;
+            kind.unpackedBytes -= unpackedBytes;
+        }
+    }
+
+    // FNV-1a over the bytes, seeded with the element type
+    static uint64_t hashBytes(const void* data, size_t size, uint64_t seed)
+    {
+        uint64_t hash = 14695981039346656037ull ^ seed;
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Looks for a live block holding exactly these bytes; on a hash match the stored copy is read
+    // back and compared, which only happens while loading. Takes a reference on success.
+    bool findBlock(BlockMap& blocks, GLuint buffer, size_t slotSize, uint64_t hash, const void* data, size_t size, size_t& offset)
+    {
+        std::vector<unsigned char> stored;
+        for (auto& block : blocks)
+        {
+            if (block.second.hash != hash || block.second.bytes != size)
+                continue;
+            stored.resize(size);
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, block.first * slotSize, size, stored.data());
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            if (memcmp(stored.data(), data, size) != 0)
+                continue;
+            ++block.second.references;
+            offset = block.first;
+            return true;
+        }
+        return false;
+    }
+
+    static void addBlock(BlockMap& blocks, size_t offset, size_t slots, uint64_t hash, size_t size)
+    {
+        Block& block = blocks[offset];
+        block.slots = slots;
+        block.bytes = size;
+        block.hash = hash;
+        block.references = 1;
+    }
+
+    static void releaseBlock(BlockMap& blocks, ArenaSpace& space, size_t offset)
+    {
+        auto it = blocks.find(offset);
+        if (it == blocks.end() || --it->second.references > 0)
+            return;
+        space.release(offset, it->second.slots);
+        blocks.erase(it);
+    }
+
+    static int savedPercent(size_t bytes, size_t unpackedBytes)
+    {
+        return unpackedBytes ? (int)(100 - 100 * bytes / unpackedBytes) : 0;
+    }
+
+    void setUpVertexArray()
+    {
+        glBindVertexArray(vao);
+        currentVertexArray = vao;
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+
+        // position, normal and texture coordinate attributes
+        if (packed)
+            setPackedVertexAttributes();
+        else
+            setFloatVertexAttributes();
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // moves the contents into a larger buffer; offsets stay valid
+    void regrow(GLBuffer& buffer, size_t oldBytes, size_t newBytes)
+    {
+        GLBuffer bigger = GLBuffer::create(GL_HERE);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, bigger);
+        glBufferData(GL_COPY_WRITE_BUFFER, newBytes, NULL, GL_STATIC_DRAW);
+        bigger.setBytes(newBytes);
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        buffer = std::move(bigger);         // deletes the old buffer
+    }
+
+    void growVertices(size_t needed)
+    {
+        size_t capacity = vertexSpace.capacity();
+        size_t grown = capacity * 2 > needed ? capacity * 2 : needed;
+        std::cout << "Geometry arena: vertex buffer grows to " << grown << " vertices" << std::endl;
+        regrow(vbo, capacity * vertexBytes(), grown * vertexBytes());
+        vertexSpace.grow(grown);
+        setUpVertexArray();
+    }
+
+    void growIndices(size_t needed)
+    {
+        size_t capacity = indexSpace.capacity();
+        size_t grown = capacity * 2 > needed ? capacity * 2 : needed;
+        std::cout << "Geometry arena: index buffer grows to " << grown << " slots" << std::endl;
+        regrow(ebo, capacity * INDEX_SLOT_SIZE, grown * INDEX_SLOT_SIZE);
+        indexSpace.grow(grown);
+        setUpVertexArray();
+    }
+
+    static void printSpace(const char* name, const ArenaSpace& space, size_t slotSize)
+    {
+        size_t capacity = space.capacity();
+        std::cout << "  " << name << ": " << space.used() << " of " << capacity << " used ("
+            << (capacity ? 100 * space.used() / capacity : 0) << "%, " << space.used() * slotSize / 1024 << " of "
+            << capacity * slotSize / 1024 << " KB), " << space.freeBlockCount() << " free blocks, largest "
+            << space.largestFreeBlock() << ", fragmentation " << (int)(space.fragmentation() * 100) << "%" << std::endl;
+    }
+
+    GeometryArena() {}
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+};
+
+#endif /* geometryArena_h */
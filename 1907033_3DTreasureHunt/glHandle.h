@@ -0,0 +1,297 @@
+//
+//  glHandle.h
+//
+
+//
+
+#ifndef glHandle_h
+#define glHandle_h
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <iostream>
+
+// Debug builds keep a record of every GL object a handle owns; release builds only count.
+#if !defined(GL_TRACK_OBJECTS)
+#if defined(NDEBUG)
+#define GL_TRACK_OBJECTS 0
+#else
+#define GL_TRACK_OBJECTS 1
+#endif
+#endif
+
+enum class GLObjectKind
+{
+    Buffer,
+    VertexArray,
+    Texture,
+    Sampler,
+    Program,
+    Count
+};
+
+inline const char* glObjectKindName(GLObjectKind kind)
+{
+    static const char* names[] = { "buffer", "vertex array", "texture", "sampler", "program" };
+    return names[(int)kind];
+}
+
+// where a GL object was created; GL_HERE fills it in
+struct GLSite
+{
+    const char* file = "unknown";
+    int line = 0;
+};
+
+#define GL_HERE GLSite{ __FILE__, __LINE__ }
+
+// Live GL objects by kind and creation site, with the bytes their owners reported. The report
+// at process exit lists whatever was never deleted; printLive() shows the live set, and how
+// it changed since the last call, while the program runs.
+class GLObjectRegistry
+{
+public:
+    static GLObjectRegistry& instance()
+    {
+        static GLObjectRegistry registry;
+        return registry;
+    }
+
+    // Handles destroyed after this (locals of main() outlive glfwTerminate) skip the GL call;
+    // the context took their objects with it.
+    void contextDestroyed()
+    {
+        contextAlive = false;
+    }
+
+    bool hasContext() const
+    {
+        return contextAlive;
+    }
+
+    void add(GLObjectKind kind, GLuint id, const GLSite& site)
+    {
+        ++live[(int)kind];
+#if GL_TRACK_OBJECTS
+        Record record;
+        record.site = site;
+        objects[key(kind, id)] = record;
+#else
+        (void)id;
+        (void)site;
+#endif
+    }
+
+    void remove(GLObjectKind kind, GLuint id)
+    {
+        --live[(int)kind];
+#if GL_TRACK_OBJECTS
+        objects.erase(key(kind, id));
+#else
+        (void)id;
+#endif
+    }
+
+    // current storage size of an object, for buffers and textures
+    void setBytes(GLObjectKind kind, GLuint id, size_t bytes)
+    {
+#if GL_TRACK_OBJECTS
+        auto it = objects.find(key(kind, id));
+        if (it != objects.end())
+            it->second.bytes = bytes;
+#else
+        (void)kind;
+        (void)id;
+        (void)bytes;
+#endif
+    }
+
+    long long liveCount(GLObjectKind kind) const
+    {
+        return live[(int)kind];
+    }
+
+    void printLive()
+    {
+        std::cout << "Live GL objects:";
+        for (int k = 0; k < (int)GLObjectKind::Count; ++k)
+        {
+            std::cout << " " << live[k] << " " << glObjectKindName((GLObjectKind)k) << "s";
+            if (live[k] != reported[k])
+                std::cout << " (" << (live[k] > reported[k] ? "+" : "") << live[k] - reported[k] << ")";
+            reported[k] = live[k];
+        }
+        std::cout << std::endl;
+        printSites("  ");
+    }
+
+    ~GLObjectRegistry()
+    {
+#if GL_TRACK_OBJECTS
+        if (objects.empty())
+            return;
+        size_t bytes = 0;
+        for (auto& object : objects)
+            bytes += object.second.bytes;
+        std::cerr << "Leaked GL objects: " << objects.size() << ", " << bytes / 1024 << " KB" << std::endl;
+        printSites("  ");
+#endif
+    }
+
+private:
+    struct Record
+    {
+        GLSite site;
+        size_t bytes = 0;
+    };
+
+    long long live[(int)GLObjectKind::Count] = {};
+    long long reported[(int)GLObjectKind::Count] = {};
+    bool contextAlive = true;
+#if GL_TRACK_OBJECTS
+    std::unordered_map<uint64_t, Record> objects;
+#endif
+
+    static uint64_t key(GLObjectKind kind, GLuint id)
+    {
+        return ((uint64_t)kind << 32) | id;
+    }
+
+    // objects grouped by kind and creation site
+    void printSites(const char* indent) const
+    {
+#if GL_TRACK_OBJECTS
+        struct Group
+        {
+            size_t count = 0;
+            size_t bytes = 0;
+        };
+        std::map<std::string, Group> groups;
+        for (auto& object : objects)
+        {
+            const Record& record = object.second;
+            std::string name = std::string(glObjectKindName((GLObjectKind)(object.first >> 32))) + " at "
+                + record.site.file + ":" + std::to_string(record.site.line);
+            Group& group = groups[name];
+            ++group.count;
+            group.bytes += record.bytes;
+        }
+        for (auto& group : groups)
+            std::cout << indent << group.second.count << " x " << group.first << ", " << group.second.bytes / 1024 << " KB" << std::endl;
+#else
+        (void)indent;
+#endif
+    }
+
+    GLObjectRegistry() {}
+    GLObjectRegistry(const GLObjectRegistry&) = delete;
+    GLObjectRegistry& operator=(const GLObjectRegistry&) = delete;
+};
+
+// Move-only owner of one GL object name. The object is created by create() and deleted when the
+// handle is destroyed, reset or assigned another object; moving transfers ownership. Converts
+// to the GL name, so it can be passed to gl* calls directly.
+template <GLObjectKind Kind>
+class GLHandle
+{
+public:
+    // touches the registry first, so it outlives the singletons and globals that own handles
+    GLHandle()
+    {
+        GLObjectRegistry::instance();
+    }
+
+    // site is recorded in debug builds: pass GL_HERE
+    static GLHandle create(GLSite site = GLSite())
+    {
+        GLHandle handle;
+        handle.id = generate();
+        if (handle.id != 0)
+            GLObjectRegistry::instance().add(Kind, handle.id, site);
+        return handle;
+    }
+
+    GLHandle(GLHandle&& other) : id(other.id)
+    {
+        other.id = 0;
+    }
+
+    GLHandle& operator=(GLHandle&& other)
+    {
+        if (this != &other)
+        {
+            reset();
+            id = other.id;
+            other.id = 0;
+        }
+        return *this;
+    }
+
+    GLHandle(const GLHandle&) = delete;
+    GLHandle& operator=(const GLHandle&) = delete;
+
+    ~GLHandle()
+    {
+        reset();
+    }
+
+    GLuint get() const
+    {
+        return id;
+    }
+
+    operator GLuint() const
+    {
+        return id;
+    }
+
+    explicit operator bool() const
+    {
+        return id != 0;
+    }
+
+    // deletes the object now
+    void reset()
+    {
+        if (id == 0)
+            return;
+        GLObjectRegistry::instance().remove(Kind, id);
+        if (GLObjectRegistry::instance().hasContext())
+            destroy(id);
+        id = 0;
+    }
+
+    void setBytes(size_t bytes) const
+    {
+        GLObjectRegistry::instance().setBytes(Kind, id, bytes);
+    }
+
+private:
+    GLuint id = 0;
+
+    static GLuint generate();
+    static void destroy(GLuint id);
+};
+
+template <> inline GLuint GLHandle<GLObjectKind::Buffer>::generate() { GLuint id = 0; glGenBuffers(1, &id); return id; }
+template <> inline GLuint GLHandle<GLObjectKind::VertexArray>::generate() { GLuint id = 0; glGenVertexArrays(1, &id); return id; }
+template <> inline GLuint GLHandle<GLObjectKind::Texture>::generate() { GLuint id = 0; glGenTextures(1, &id); return id; }
+template <> inline GLuint GLHandle<GLObjectKind::Sampler>::generate() { GLuint id = 0; glGenSamplers(1, &id); return id; }
+template <> inline GLuint GLHandle<GLObjectKind::Program>::generate() { return glCreateProgram(); }
+
+template <> inline void GLHandle<GLObjectKind::Buffer>::destroy(GLuint id) { glDeleteBuffers(1, &id); }
+template <> inline void GLHandle<GLObjectKind::VertexArray>::destroy(GLuint id) { glDeleteVertexArrays(1, &id); }
+template <> inline void GLHandle<GLObjectKind::Texture>::destroy(GLuint id) { glDeleteTextures(1, &id); }
+template <> inline void GLHandle<GLObjectKind::Sampler>::destroy(GLuint id) { glDeleteSamplers(1, &id); }
+template <> inline void GLHandle<GLObjectKind::Program>::destroy(GLuint id) { glDeleteProgram(id); }
+
+typedef GLHandle<GLObjectKind::Buffer> GLBuffer;
+typedef GLHandle<GLObjectKind::VertexArray> GLVertexArray;
+typedef GLHandle<GLObjectKind::Texture> GLTexture;
+typedef GLHandle<GLObjectKind::Sampler> GLSampler;
+typedef GLHandle<GLObjectKind::Program> GLProgram;
+
+#endif /* glHandle_h */
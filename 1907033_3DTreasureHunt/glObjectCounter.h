@@ -0,0 +1,158 @@
+//
+//  glObjectCounter.h
+//
+
+//
+
+#ifndef glObjectCounter_h
+#define glObjectCounter_h
+
+#include <glad/glad.h>
+#include <iostream>
+#include "glHandle.h"      // GL_TRACK_OBJECTS
+
+// Counts the GL objects the program creates by wrapping glad's function pointers for
+// glGenBuffers, glGenVertexArrays, glGenTextures and glGenSamplers. Install it right after
+// gladLoadGLLoader(); from then on endFrame() reports every frame that created an object,
+// which in the steady state of a room should be none. Only debug builds (GL_TRACK_OBJECTS)
+// install the wrappers; release builds call glad directly and count nothing.
+class GLObjectCounter
+{
+public:
+    static GLObjectCounter& instance()
+    {
+        static GLObjectCounter counter;
+        return counter;
+    }
+
+    void install()
+    {
+        if (installed)
+            return;
+        installed = true;
+#if GL_TRACK_OBJECTS
+        realGenBuffers() = glad_glGenBuffers;
+        realGenVertexArrays() = glad_glGenVertexArrays;
+        realGenTextures() = glad_glGenTextures;
+        realGenSamplers() = glad_glGenSamplers;
+        glad_glGenBuffers = countGenBuffers;
+        glad_glGenVertexArrays = countGenVertexArrays;
+        glad_glGenTextures = countGenTextures;
+        glad_glGenSamplers = countGenSamplers;
+#endif
+    }
+
+    // Call once per frame. Frames that created objects are reported, except for the first few
+    // after startup or expectLoading(), when creating them is expected.
+    void endFrame()
+    {
+        ++frame;
+        if (createdThisFrame != 0)
+        {
+            ++framesCreating;
+            if (frame > quietAfterFrame)
+            {
+                ++steadyFramesCreating;
+                std::cout << "Frame " << frame << " created " << createdThisFrame << " GL objects ("
+                    << buffers << " buffers, " << vertexArrays << " vertex arrays, " << textures
+                    << " textures, " << samplers << " samplers so far)" << std::endl;
+            }
+        }
+        createdThisFrame = 0;
+    }
+
+    // expected creations follow (room change); they are not reported for a few frames
+    void expectLoading(unsigned long long warmupFrames = WARMUP_FRAMES)
+    {
+        quietAfterFrame = frame + warmupFrames;
+    }
+
+    unsigned long long total() const
+    {
+        return buffers + vertexArrays + textures + samplers;
+    }
+
+    void printStats() const
+    {
+#if !GL_TRACK_OBJECTS
+        std::cout << "GL objects created: not counted in release builds" << std::endl;
+        return;
+#endif
+        std::cout << "GL objects created: " << total() << " (" << buffers << " buffers, " << vertexArrays
+            << " vertex arrays, " << textures << " textures, " << samplers << " samplers); "
+            << framesCreating << " of " << frame << " frames created objects, "
+            << steadyFramesCreating << " outside loading" << std::endl;
+    }
+
+private:
+    static const unsigned long long WARMUP_FRAMES = 10;
+
+    bool installed = false;
+    unsigned long long buffers = 0;
+    unsigned long long vertexArrays = 0;
+    unsigned long long textures = 0;
+    unsigned long long samplers = 0;
+    unsigned long long createdThisFrame = 0;
+    unsigned long long frame = 0;
+    unsigned long long framesCreating = 0;
+    unsigned long long steadyFramesCreating = 0;
+    unsigned long long quietAfterFrame = WARMUP_FRAMES;
+
+    static PFNGLGENBUFFERSPROC& realGenBuffers()
+    {
+        static PFNGLGENBUFFERSPROC function = nullptr;
+        return function;
+    }
+
+    static PFNGLGENVERTEXARRAYSPROC& realGenVertexArrays()
+    {
+        static PFNGLGENVERTEXARRAYSPROC function = nullptr;
+        return function;
+    }
+
+    static PFNGLGENTEXTURESPROC& realGenTextures()
+    {
+        static PFNGLGENTEXTURESPROC function = nullptr;
+        return function;
+    }
+
+    static PFNGLGENSAMPLERSPROC& realGenSamplers()
+    {
+        static PFNGLGENSAMPLERSPROC function = nullptr;
+        return function;
+    }
+
+    static void APIENTRY countGenBuffers(GLsizei n, GLuint* names)
+    {
+        instance().buffers += n;
+        instance().createdThisFrame += n;
+        realGenBuffers()(n, names);
+    }
+
+    static void APIENTRY countGenVertexArrays(GLsizei n, GLuint* names)
+    {
+        instance().vertexArrays += n;
+        instance().createdThisFrame += n;
+        realGenVertexArrays()(n, names);
+    }
+
+    static void APIENTRY countGenTextures(GLsizei n, GLuint* names)
+    {
+        instance().textures += n;
+        instance().createdThisFrame += n;
+        realGenTextures()(n, names);
+    }
+
+    static void APIENTRY countGenSamplers(GLsizei n, GLuint* names)
+    {
+        instance().samplers += n;
+        instance().createdThisFrame += n;
+        realGenSamplers()(n, names);
+    }
+
+    GLObjectCounter() {}
+    GLObjectCounter(const GLObjectCounter&) = delete;
+    GLObjectCounter& operator=(const GLObjectCounter&) = delete;
+};
+
+#endif /* glObjectCounter_h */
@@ -12,8 +12,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "shader.h"
-
-# define PI 3.1416
+#include "geometryArena.h"
+#include "drawUniforms.h"
+#include "revolution.h"
 
 using namespace std;
 
@@ -28,49 +29,21 @@ public:
     glm::vec3 specular;
     glm::vec3 emmisive;
     float shininess;
+    MaterialId material = MaterialTable::DEFAULT;  // entry of the colours above in the material table (materialTable.h)
     // ctor/dtor
     Hemisphere(float radius = 1.0f, int sectorCount = 20, int stackCount = 18, glm::vec3 amb = glm::vec3(1.0f, 1.0f, 0.0f), glm::vec3 diff = glm::vec3(1.0f, 1.0f, 0.0f), glm::vec3 spec = glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3 em = glm::vec3(0.0f, 0.0f, 0.0f), float shiny = 32.0f) : verticesStride(24)
     {
         set(radius, sectorCount, stackCount, amb, diff, spec,em, shiny);
-        buildCoordinatesAndIndices();
-        buildVertices();
-
-        glGenVertexArrays(1, &sphereVAO);
-        glBindVertexArray(sphereVAO);
-
-        // create VBO to copy vertex data to VBO
-        unsigned int sphereVBO;
-        glGenBuffers(1, &sphereVBO);
-        glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);           // for vertex data
-        glBufferData(GL_ARRAY_BUFFER,                   // target
-            this->getVertexSize(), // data size, # of bytes
-            this->getVertices(),   // ptr to vertex data
-            GL_STATIC_DRAW);                   // usage
-
-        // create EBO to copy index data
-        unsigned int sphereEBO;
-        glGenBuffers(1, &sphereEBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);   // for index data
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,           // target
-            this->getIndexSize(),             // data size, # of bytes
-            this->getIndices(),               // ptr to index data
-            GL_STATIC_DRAW);                   // usage
-
-        // activate attrib arrays
-        glEnableVertexAttribArray(0);
-        glEnableVertexAttribArray(1);
-
-        // set attrib arrays with stride and offset
-        int stride = this->getVerticesStride();     // should be 24 bytes
-        glVertexAttribPointer(0, 3, GL_FLOAT, false, stride, (void*)0);
-        glVertexAttribPointer(1, 3, GL_FLOAT, false, stride, (void*)(sizeof(float) * 3));
-
-        // unbind VAO and VBOs
-        glBindVertexArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        buildMesh();
+
+        // vertices and indices go into the shared geometry arena
+        mesh = GeometryArena::instance().allocate(getVertices(), getVertexCount(), 6, getIndices(), getIndexCount(), "Hemisphere");
+    }
+    ~Hemisphere() {
+        GeometryArena::instance().release(mesh);
     }
-    ~Hemisphere() {}
+    Hemisphere(const Hemisphere&) = delete;
+    Hemisphere& operator=(const Hemisphere&) = delete;
 
     // getters/setters
 
@@ -89,6 +62,7 @@ public:
         this->specular = spec;
         this->emmisive = em;
         this->shininess = shiny;
+        material = MaterialTable::instance().add(ambient, diffuse, specular, shininess, emmisive);
     }
 
     void setRadius(float radius)
@@ -112,7 +86,7 @@ public:
     // for interleaved vertices
     unsigned int getVertexCount() const
     {
-        return (unsigned int)coordinates.size() / 3;     // # of vertices
+        return (unsigned int)vertices.size() / 6;     // # of vertices
     }
 
     unsigned int getVertexSize() const
@@ -149,125 +123,18 @@ public:
     {
         lightingShader.use();
 
-        lightingShader.setVec3("material.ambient", this->ambient);
-        lightingShader.setVec3("material.diffuse", this->diffuse);
-        lightingShader.setVec3("material.specular", this->specular);
-        lightingShader.setVec3("material.emissive", this->emmisive);
-        lightingShader.setFloat("material.shininess", this->shininess);
-
-        lightingShader.setMat4("model", model);
-
-        // draw a sphere with VAO
-        glBindVertexArray(sphereVAO);
-        glDrawElements(GL_TRIANGLES,                    // primitive type
-            this->getIndexCount(),          // # of indices
-            GL_UNSIGNED_INT,                 // data type
-            (void*)0);                       // offset to indices
+        DrawUniforms::instance().push(model, material);
 
-        // unbind VAO
-        glBindVertexArray(0);
+        GeometryArena::instance().draw(mesh);
     }
 
 private:
     // member functions
-    void buildCoordinatesAndIndices()
+    void buildMesh()
     {
-        float x, y, z, xz;                              // vertex position
-        float nx, ny, nz, lengthInv = 1.0f / radius;    // vertex normal
-
-        float sectorStep = 2 * PI / sectorCount;
-        float stackStep = PI / stackCount;
-        float sectorAngle = -sectorStep;
-        float stackAngle = PI / 2 + stackStep;
-
-        for (int i = 0; i <= stackCount; ++i)
-        {
-            stackAngle -= stackStep;        // starting from pi/2 to -pi/2
-            xz = radius * cosf(stackAngle);
-            y = radius * sinf(stackAngle);
-            // add (sectorCount+1) vertices per stack
-            // first and last vertices have same position and normal, but different tex coords
-            for (int j = 0; j <= sectorCount; ++j)
-            {
-                sectorAngle += sectorStep;           // starting from 0 to 2pi
-
-                // vertex position (x, y, z)
-                z = xz * cosf(sectorAngle);
-                x = xz * sinf(sectorAngle);
-                coordinates.push_back(x);
-                coordinates.push_back(y);
-                coordinates.push_back(z);
-
-                // normalized vertex normal (nx, ny, nz)
-                nx = x * lengthInv;
-                ny = y * lengthInv;
-                nz = z * lengthInv;
-                normals.push_back(nx);
-                normals.push_back(ny);
-                normals.push_back(nz);
-            }
-        }
-
-        // generate index list of sphere triangles
-        // k1--k1+1
-        // |  / |
-        // | /  |
-        // k2--k2+1
-
-        int k1, k2;
-        for (int i = 0; i < stackCount/2; ++i)
-        {
-            k1 = i * (sectorCount + 1);     // beginning of current stack
-            k2 = k1 + sectorCount + 1;      // beginning of next stack
-
-            for (int j = 0; j < sectorCount; ++j, ++k1, ++k2)
-            {
-                // 2 triangles per sector excluding first and last stacks
-                if (i != 0 && i != (stackCount - 1))
-                {
-                    // k1 => k2 => k1+1
-                    indices.push_back(k1);
-                    indices.push_back(k2);
-                    indices.push_back(k1 + 1);
-
-                    // k1+1 => k2 => k2+1
-                    indices.push_back(k1 + 1);
-                    indices.push_back(k2);
-                    indices.push_back(k2 + 1);
-                }
-                // 2 triangles per sector excluding first and last stacks
-                else if (i == 0)
-                {
-                    indices.push_back(k1 + 1);
-                    indices.push_back(k2);
-                    indices.push_back(k2 + 1);
-
-                }
-
-                else if (i == (stackCount - 1))
-                {
-                    indices.push_back(k1);
-                    indices.push_back(k2);
-                    indices.push_back(k1 + 1);
-                }
-            }
-        }
-    }
-
-    void buildVertices()
-    {
-        size_t i, j;
-        size_t count = coordinates.size();
-        for (i = 0, j = 0; i < count; i += 3, j += 2)
-        {
-            vertices.push_back(coordinates[i]);
-            vertices.push_back(coordinates[i + 1]);
-            vertices.push_back(coordinates[i + 2]);
-
-            vertices.push_back(normals[i]);
-            vertices.push_back(normals[i + 1]);
-            vertices.push_back(normals[i + 2]);
-        }
+        // upper half of the sphere's rings; x = r sin(a), z = r cos(a) like sphere.h
+        buildRevolutionSpecialized<false>(SphereProfile(radius, stackCount, stackCount / 2 + 1), sectorCount,
+            (float)(PI / 2), (float)(-2 * PI), nullptr, 0, vertices, indices);
     }
 
     vector<float> computeFaceNormal(float x1, float y1, float z1, float x2, float y2, float z2, float x3, float y3, float z3)
@@ -305,14 +172,12 @@ private:
     }
 
     // memeber vars
-    unsigned int sphereVAO;
+    ArenaMesh mesh;             // range in the shared geometry arena
     float radius;
     int sectorCount;                        // longitude, # of slices
     int stackCount;                         // latitude, # of stacks
     vector<float> vertices;
-    vector<float> normals;
     vector<unsigned int> indices;
-    vector<float> coordinates;
     int verticesStride;                 // # of bytes to hop to the next vertex (should be 24 bytes)
 
 };
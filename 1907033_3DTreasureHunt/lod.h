@@ -0,0 +1,477 @@
+//
+//  lod.h
+//
+
+//
+
+#ifndef lod_h
+#define lod_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <utility>
+#include <queue>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include "geometryArena.h"
+#include "revolution.h"
+
+// Levels of detail of one mesh, finest first, each a range in the geometry arena. A level is
+// good enough while the mesh covers at least minPixels (screen-space diameter); the thresholds
+// come from how far each level's silhouette polygon strays from the true outline.
+class LodChain
+{
+public:
+    static constexpr float MAX_ERROR_PIXELS = 0.5f;    // allowed silhouette error
+    static constexpr float HYSTERESIS = 0.15f;         // a level changes only 15% past its threshold
+
+    // detail is the number of segments around the silhouette (the sector count of a
+    // parametric mesh); the previous level's threshold is derived from it
+    void addLevel(const ArenaMesh& mesh, float detail)
+    {
+        Level level = { mesh, 0.0f };
+        if (!levels.empty())
+        {
+            // the previous level is needed while a polygon of this level's detail, inscribed in
+            // the silhouette, falls more than MAX_ERROR_PIXELS short of it
+            float sagitta = 1.0f - cosf((float)PI / (detail > 3.0f ? detail : 3.0f));
+            levels.back().minPixels = 2.0f * MAX_ERROR_PIXELS / sagitta;
+        }
+        levels.push_back(level);
+    }
+
+    size_t levelCount() const
+    {
+        return levels.size();
+    }
+
+    const ArenaMesh& level(int i) const
+    {
+        static const ArenaMesh none;
+        if (levels.empty())
+            return none;
+        return levels[i < 0 ? 0 : (i >= (int)levels.size() ? levels.size() - 1 : i)].mesh;
+    }
+
+    GLuint triangles(int i) const
+    {
+        return level(i).indexCount / 3;
+    }
+
+    // bounding sphere radius around the mesh's origin, for the screen-size estimate
+    float radius = 1.0f;
+
+    // Level for a mesh covering pixels, starting from the level used last time. Switching needs
+    // the size to move HYSTERESIS past a threshold, so a mesh near one does not flicker.
+    int select(float pixels, int current) const
+    {
+        int last = (int)levels.size() - 1;
+        if (current < 0 || current > last)
+            current = 0;
+        while (current > 0 && pixels > levels[current - 1].minPixels * (1.0f + HYSTERESIS))
+            --current;
+        while (current < last && pixels < levels[current].minPixels * (1.0f - HYSTERESIS))
+            ++current;
+        return current;
+    }
+
+    void release()
+    {
+        for (Level& level : levels)
+            GeometryArena::instance().release(level.mesh);
+        levels.clear();
+    }
+
+private:
+    struct Level
+    {
+        ArenaMesh mesh;
+        float minPixels;    // 0 for the coarsest level
+    };
+    std::vector<Level> levels;
+};
+
+// largest distance of a vertex from the mesh origin
+inline float meshRadius(const float* vertices, size_t vertexCount, int floatsPerVertex)
+{
+    float radiusSquared = 0.0f;
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const float* p = vertices + i * floatsPerVertex;
+        float d = p[0] * p[0] + p[1] * p[1] + p[2] * p[2];
+        if (d > radiusSquared)
+            radiusSquared = d;
+    }
+    return sqrtf(radiusSquared);
+}
+
+// Sector and stack counts of the levels of a parametric mesh, finest first: each coarser level
+// halves both counts until the sectors drop below minSectors (stacks stop at minStacks)
+inline std::vector<std::pair<int, int>> lodTessellations(int sectors, int stacks, int minSectors, int minStacks)
+{
+    std::vector<std::pair<int, int>> levels;
+    levels.push_back(std::make_pair(sectors, stacks));
+    while (true)
+    {
+        sectors /= 2;
+        stacks = stacks / 2 > minStacks ? stacks / 2 : minStacks;
+        if (sectors < minSectors)
+            break;
+        levels.push_back(std::make_pair(sectors, stacks));
+    }
+    return levels;
+}
+
+// Chain of a parametric mesh: build(sectors, stacks, vertices, indices) tessellates each level of
+// lodTessellations(); the finest level is the one passed in. split(sectors, stacks), when given,
+// is an index position that has to stay a separate range (see GeometryArena::allocate()).
+template <typename Build>
+void buildLodChain(LodChain& chain, const char* name, const std::vector<float>& vertices, const std::vector<unsigned int>& indices,
+    int sectors, int stacks, int minSectors, int minStacks, Build build, size_t (*split)(int sectors, int stacks) = nullptr)
+{
+    GeometryArena& arena = GeometryArena::instance();
+    chain.radius = meshRadius(vertices.data(), vertices.size() / 8, 8);
+    std::vector<std::pair<int, int>> levels = lodTessellations(sectors, stacks, minSectors, minStacks);
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        std::vector<float> levelVertices;
+        std::vector<unsigned int> levelIndices;
+        if (i > 0)
+            build(levels[i].first, levels[i].second, levelVertices, levelIndices);
+        const std::vector<float>& v = i > 0 ? levelVertices : vertices;
+        const std::vector<unsigned int>& ix = i > 0 ? levelIndices : indices;
+        std::vector<size_t> splits;
+        if (split)
+            splits.push_back(split(levels[i].first, levels[i].second));
+        chain.addLevel(arena.allocate(v.data(), v.size() / 8, 8, ix.data(), ix.size(), name, split ? &splits : nullptr), (float)levels[i].first);
+    }
+}
+
+// Garland-Heckbert quadric error simplification by half-edge collapses: a vertex is merged into
+// a neighbour, so every level reuses the original vertices and only the index list shrinks.
+// Collapses go cheapest first until at most targetIndexCount indices are left or none is
+// allowed. Vertices that share their position with another (uv seams) stay put and border
+// vertices only slide along the border, so no cracks open; collapses that would flip a
+// triangle are skipped.
+inline void simplifyQuadric(const float* vertices, size_t vertexCount, int floatsPerVertex, const unsigned int* indices, size_t indexCount,
+    size_t targetIndexCount, std::vector<unsigned int>& out)
+{
+    struct Quadric
+    {
+        double a[10] = {};  // symmetric 4x4: xx xy xz xw yy yz yw zz zw ww
+
+        void addPlane(double nx, double ny, double nz, double d, double weight)
+        {
+            double p[4] = { nx, ny, nz, d };
+            int k = 0;
+            for (int i = 0; i < 4; ++i)
+                for (int j = i; j < 4; ++j)
+                    a[k++] += weight * p[i] * p[j];
+        }
+
+        void add(const Quadric& other)
+        {
+            for (int k = 0; k < 10; ++k)
+                a[k] += other.a[k];
+        }
+
+        double error(const float* p) const
+        {
+            double x = p[0], y = p[1], z = p[2];
+            return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + 2 * a[3] * x
+                + a[4] * y * y + 2 * a[5] * y * z + 2 * a[6] * y
+                + a[7] * z * z + 2 * a[8] * z
+                + a[9];
+        }
+    };
+
+    std::vector<unsigned int> triangles(indices, indices + indexCount);
+    size_t triangleCount = indexCount / 3;
+    auto position = [&](unsigned int v) { return vertices + (size_t)v * floatsPerVertex; };
+    auto edgeKey = [](unsigned int a, unsigned int b) { return ((uint64_t)a << 32) | b; };
+
+    // vertices with a twin at the same position
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::unordered_map<std::string, unsigned int> byPosition;
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            auto found = byPosition.emplace(std::string((const char*)position((unsigned int)v), 3 * sizeof(float)), (unsigned int)v);
+            if (!found.second)
+                locked[v] = locked[found.first->second] = true;
+        }
+    }
+
+    // border edges have a triangle on one side only
+    std::unordered_set<uint64_t> directedEdges;
+    for (size_t t = 0; t < triangleCount; ++t)
+        for (int k = 0; k < 3; ++k)
+            directedEdges.insert(edgeKey(triangles[t * 3 + k], triangles[t * 3 + (k + 1) % 3]));
+    std::unordered_set<uint64_t> borderEdges;
+    std::vector<bool> border(vertexCount, false);
+    for (uint64_t edge : directedEdges)
+    {
+        unsigned int a = (unsigned int)(edge >> 32), b = (unsigned int)edge;
+        if (directedEdges.count(edgeKey(b, a)) == 0)
+        {
+            borderEdges.insert(edgeKey(a, b));
+            borderEdges.insert(edgeKey(b, a));
+            border[a] = border[b] = true;
+        }
+    }
+
+    // area weighted face planes, plus steep planes through border edges to hold the outline
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<std::vector<unsigned int>> vertexTriangles(vertexCount);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        const unsigned int* tri = &triangles[t * 3];
+        glm::dvec3 p0(position(tri[0])[0], position(tri[0])[1], position(tri[0])[2]);
+        glm::dvec3 p1(position(tri[1])[0], position(tri[1])[1], position(tri[1])[2]);
+        glm::dvec3 p2(position(tri[2])[0], position(tri[2])[1], position(tri[2])[2]);
+        glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        double area = glm::length(normal);
+        if (area > 0.0)
+        {
+            normal /= area;
+            for (int k = 0; k < 3; ++k)
+                quadrics[tri[k]].addPlane(normal.x, normal.y, normal.z, -glm::dot(normal, p0), area * 0.5);
+            glm::dvec3 corners[3] = { p0, p1, p2 };
+            for (int k = 0; k < 3; ++k)
+            {
+                if (borderEdges.count(edgeKey(tri[k], tri[(k + 1) % 3])) == 0)
+                    continue;
+                glm::dvec3 edge = corners[(k + 1) % 3] - corners[k];
+                glm::dvec3 side = glm::cross(edge, normal);
+                double length = glm::length(side);
+                if (length <= 0.0)
+                    continue;
+                side /= length;
+                double weight = glm::dot(edge, edge) * 10.0;
+                quadrics[tri[k]].addPlane(side.x, side.y, side.z, -glm::dot(side, corners[k]), weight);
+                quadrics[tri[(k + 1) % 3]].addPlane(side.x, side.y, side.z, -glm::dot(side, corners[k]), weight);
+            }
+        }
+        for (int k = 0; k < 3; ++k)
+            vertexTriangles[tri[k]].push_back((unsigned int)t);
+    }
+
+    std::vector<bool> removedTriangle(triangleCount, false);
+    std::vector<bool> removedVertex(vertexCount, false);
+    std::vector<unsigned int> version(vertexCount, 0);
+
+    struct Candidate
+    {
+        double cost;
+        unsigned int from, to;
+        unsigned int fromVersion, toVersion;
+        bool operator<(const Candidate& other) const { return cost > other.cost; }     // min-heap
+    };
+    std::priority_queue<Candidate> queue;
+    auto canCollapse = [&](unsigned int from, unsigned int to) {
+        if (locked[from])
+            return false;
+        return !border[from] || borderEdges.count(edgeKey(from, to)) != 0;
+    };
+    auto push = [&](unsigned int from, unsigned int to) {
+        if (!canCollapse(from, to))
+            return;
+        Quadric q = quadrics[from];
+        q.add(quadrics[to]);
+        Candidate candidate = { q.error(position(to)), from, to, version[from], version[to] };
+        queue.push(candidate);
+    };
+    for (size_t t = 0; t < triangleCount; ++t)
+        for (int k = 0; k < 3; ++k)
+        {
+            push(triangles[t * 3 + k], triangles[t * 3 + (k + 1) % 3]);
+            push(triangles[t * 3 + (k + 1) % 3], triangles[t * 3 + k]);
+        }
+
+    size_t liveTriangles = triangleCount;
+    while (liveTriangles * 3 > targetIndexCount && !queue.empty())
+    {
+        Candidate c = queue.top();
+        queue.pop();
+        if (removedVertex[c.from] || removedVertex[c.to] || version[c.from] != c.fromVersion || version[c.to] != c.toVersion)
+            continue;
+
+        // still an edge, and moving from onto to turns no remaining triangle over
+        bool adjacent = false, flips = false;
+        for (unsigned int t : vertexTriangles[c.from])
+        {
+            if (removedTriangle[t])
+                continue;
+            unsigned int* tri = &triangles[t * 3];
+            if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+            {
+                adjacent = true;
+                continue;
+            }
+            glm::vec3 p[3], q[3];
+            for (int k = 0; k < 3; ++k)
+            {
+                p[k] = glm::vec3(position(tri[k])[0], position(tri[k])[1], position(tri[k])[2]);
+                unsigned int moved = tri[k] == c.from ? c.to : tri[k];
+                q[k] = glm::vec3(position(moved)[0], position(moved)[1], position(moved)[2]);
+            }
+            glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+            if (glm::dot(before, after) <= 0.0f)
+            {
+                flips = true;
+                break;
+            }
+        }
+        if (!adjacent || flips)
+            continue;
+
+        for (unsigned int t : vertexTriangles[c.from])
+        {
+            if (removedTriangle[t])
+                continue;
+            unsigned int* tri = &triangles[t * 3];
+            if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+            {
+                removedTriangle[t] = true;
+                --liveTriangles;
+                continue;
+            }
+            for (int k = 0; k < 3; ++k)
+                if (tri[k] == c.from)
+                    tri[k] = c.to;
+            vertexTriangles[c.to].push_back(t);
+        }
+        removedVertex[c.from] = true;
+        quadrics[c.to].add(quadrics[c.from]);
+        ++version[c.to];
+
+        // the new version of to dropped its queued edges; queue them again with the merged quadric
+        for (unsigned int t : vertexTriangles[c.to])
+        {
+            if (removedTriangle[t])
+                continue;
+            for (int k = 0; k < 3; ++k)
+            {
+                unsigned int other = triangles[t * 3 + k];
+                if (other == c.to)
+                    continue;
+                push(c.to, other);
+                push(other, c.to);
+            }
+        }
+    }
+
+    out.clear();
+    out.reserve(liveTriangles * 3);
+    for (size_t t = 0; t < triangleCount; ++t)
+        if (!removedTriangle[t])
+            out.insert(out.end(), &triangles[t * 3], &triangles[t * 3] + 3);
+}
+
+// Chain of a loaded mesh: the full mesh, then quadric-simplified levels of half, a quarter and
+// an eighth of its triangles, as far as the simplifier gets.
+inline void buildSimplifiedLodChain(LodChain& chain, const char* name, const float* vertices, size_t vertexCount, int floatsPerVertex,
+    const unsigned int* indices, size_t indexCount)
+{
+    GeometryArena& arena = GeometryArena::instance();
+    chain.radius = meshRadius(vertices, vertexCount, floatsPerVertex);
+    chain.addLevel(arena.allocate(vertices, vertexCount, floatsPerVertex, indices, indexCount, name), sqrtf((float)(indexCount / 3)));
+
+    size_t previous = indexCount;
+    for (int level = 1; level <= 3; ++level)
+    {
+        std::vector<unsigned int> simplified;
+        simplifyQuadric(vertices, vertexCount, floatsPerVertex, indices, indexCount, indexCount >> level, simplified);
+        if (simplified.empty() || simplified.size() > previous * 3 / 4)
+            break;      // the simplifier got stuck; a level this close to the last one is not worth it
+        chain.addLevel(arena.allocate(vertices, vertexCount, floatsPerVertex, simplified.data(), simplified.size(), name),
+            sqrtf((float)(simplified.size() / 3)));
+        previous = simplified.size();
+    }
+}
+
+// Picks the level to draw for each mesh instance from its projected size and counts what the
+// frame submitted, with and without level of detail. GL thread only.
+class LodSelector
+{
+public:
+    static LodSelector& instance()
+    {
+        static LodSelector selector;
+        return selector;
+    }
+
+    bool enabled = true;
+
+    // once per frame, before drawing
+    void setView(const glm::mat4& view, const glm::mat4& projection)
+    {
+        this->view = view;
+        projectionScale = projection[1][1];
+    }
+
+    void setViewportHeight(int height)
+    {
+        viewportHeight = (float)height;
+    }
+
+    // screen-space diameter in pixels of a sphere of localRadius around the model's origin
+    float projectedSize(const glm::mat4& model, float localRadius) const
+    {
+        float scale = glm::length(glm::vec3(model[0]));
+        scale = glm::max(scale, glm::length(glm::vec3(model[1])));
+        scale = glm::max(scale, glm::length(glm::vec3(model[2])));
+        float depth = -(view * model[3]).z;
+        if (depth < 0.01f)
+            return 1e9f;    // the camera is inside or right at it
+        return localRadius * scale * 2.0f * projectionScale / depth * 0.5f * viewportHeight;
+    }
+
+    // Level of chain to draw with this model matrix. lodLevel carries the level an instance used
+    // last frame (for hysteresis); without one the finest level is drawn.
+    const ArenaMesh& choose(const LodChain& chain, const glm::mat4& model, int* lodLevel)
+    {
+        int level = 0;
+        if (lodLevel)
+        {
+            *lodLevel = chain.select(projectedSize(model, chain.radius), *lodLevel);
+            if (enabled)
+                level = *lodLevel;
+        }
+        trianglesThisFrame += chain.triangles(level);
+        fullDetailThisFrame += chain.triangles(0);
+        return chain.level(level);
+    }
+
+    void endFrame()
+    {
+        lastFrameTriangles = trianglesThisFrame;
+        lastFrameFullDetail = fullDetailThisFrame;
+        trianglesThisFrame = fullDetailThisFrame = 0;
+    }
+
+    void printStats() const
+    {
+        std::cout << "Level of detail " << (enabled ? "on" : "off") << ": " << lastFrameTriangles << " triangles submitted last frame, "
+            << lastFrameFullDetail << " at full detail" << std::endl;
+    }
+
+private:
+    glm::mat4 view = glm::mat4(1.0f);
+    float projectionScale = 1.0f;
+    float viewportHeight = 1.0f;
+    unsigned long long trianglesThisFrame = 0, fullDetailThisFrame = 0;
+    unsigned long long lastFrameTriangles = 0, lastFrameFullDetail = 0;
+
+    LodSelector() {}
+    LodSelector(const LodSelector&) = delete;
+    LodSelector& operator=(const LodSelector&) = delete;
+};
+
+#endif /* lod_h */
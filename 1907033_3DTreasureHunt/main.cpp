@@ -10,10 +10,24 @@
 #include "cube.h"
 #include "chest.h"
 #include "stb_image.h"
+#include "textureCache.h"
+#include "textureArray.h"
+#include "assetPrefetcher.h"
+#include "meshRegistry.h"
+#include "glObjectCounter.h"
+#include "glHandle.h"
+#include "geometryArena.h"
+#include "boxGeometry.h"
+#include "lod.h"
 #include "sphereWithTexture.h"
 #include "hemiWithTex.h"
 #include "coneWithTexture.h"
 #include "cylinderWithTexture.h"
+#include "tessellatedSurfaces.h"
+#include "frameUniforms.h"
+#include "drawUniforms.h"
+#include "materialTable.h"
+#include "normalMatrixBenchmark.h"
 #include "CurveWithTexture.h"
 #include "LeftFaceTexturedCube.h"
 #include "shader.h"
@@ -34,21 +48,44 @@
 #include <iostream>
 
 using namespace std;
+
+// The classroom's cubes, queued by drawCube() and MaterialSpec() and drawn once they are all
+// known, so their DrawData go up in one write instead of one per cube
+struct CubeDraws {
+    DrawBatch batch;
+    std::vector<int> repeats;   // times each cube is drawn
+
+    void add(const glm::mat4& model, MaterialId material, int times = 1) {
+        batch.add(model * glm::scale(glm::mat4(1.0f), glm::vec3(0.5f)), material);
+        repeats.push_back(times);
+    }
+
+    void draw(const ArenaMesh& cubeMesh, Shader& lightingShader) {
+        lightingShader.use();
+        batch.write();
+        for (size_t i = 0; i < repeats.size(); ++i) {
+            batch.bind(i);
+            for (int time = 0; time < repeats[i]; ++time)
+                GeometryArena::instance().draw(cubeMesh);
+        }
+    }
+};
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
-void drawCube(unsigned int& cubeVAO, Shader& lightingShader, glm::mat4 model, float r, float g, float b, float a);
-void drawTableChair(Shader& shaderProgram, unsigned int VAO, glm::mat4 parentTrans);
-void DrawRoom(Shader& shaderProgram, unsigned int VAO, glm::mat4 model);
-void classroom(unsigned int& cubeVAO, Shader& lightingShader, glm::mat4 alTogether);
+void drawCube(CubeDraws& cubes, glm::mat4 model, float r, float g, float b, int times);
+void drawTableChair(CubeDraws& cubes, glm::mat4 parentTrans);
+void DrawRoom(CubeDraws& cubes, glm::mat4 model);
+void classroom(const ArenaMesh& cubeMesh, Shader& lightingShader, glm::mat4 alTogether);
 unsigned int loadTexture(const char* path, GLint wrapS, GLint wrapT, GLint minFilter, GLint magFilter);
 void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 void onMouseClick(double mouseX, double mouseY, int screenWidth, int screenHeight, glm::vec3 cameraPos, glm::mat4 viewMatrix, glm::mat4 projectionMatrix);
 bool intersectObject(glm::vec3 rayOrigin, glm::vec3 rayDirection, glm::vec3 sphereCenter, float radius);
-void renderLevel1(Shader& shader, GLFWwindow* window, glm::mat4 view, glm::mat4 projection);
-void renderLevel2(Shader& shader, GLFWwindow* window, glm::mat4 view, glm::mat4 projection);
-void MaterialSpec(unsigned int& cubeVAO, Shader& lightingShader, glm::mat4 model, float ra, float ga, float ba, float rd, float gd, float bd, float rs, float gs, float bs, float shininess, float re, float ge, float be);
+void renderLevel1(Shader& shader, GLFWwindow* window);
+void renderLevel2(Shader& shader, GLFWwindow* window);
+void MaterialSpec(CubeDraws& cubes, glm::mat4 model, float ra, float ga, float ba, float rd, float gd, float bd, float rs, float gs, float bs, float shininess, float re, float ge, float be);
 
 
 
@@ -154,7 +191,7 @@ void renderCar(Cube& carBody, CylinderWithTexture& wheel, Shader& shader, float
         model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
         model = glm::rotate(model, glm::radians(wheelAngle), glm::vec3(0.0f, 1.0f, 0.0f));
         model = glm::scale(model, glm::vec3(0.5f, 0.5f, 0.5f));
-        wheel.drawCylinder(shader, model, glm::vec3(0.0f, 0.0f, 0.0f));
+        wheel.drawCylinder(shader, model);
     }
 }
 
@@ -195,7 +232,7 @@ void renderCar1(Cube& carBody, CylinderWithTexture& wheel, Shader& shader, float
         model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
         model = glm::rotate(model, glm::radians(wheelAngle), glm::vec3(0.0f, 1.0f, 0.0f));
         model = glm::scale(model, glm::vec3(0.5f,0.5f,0.5f));
-        wheel.drawCylinder(shader, model, glm::vec3(0.0f, 0.0f, 0.0f));
+        wheel.drawCylinder(shader, model);
     }
 }
 
@@ -258,41 +295,58 @@ struct Object {
     bool hasKey;
     ObjectType type;
     void* renderable;
-    unsigned int textureDiffuse;
-    unsigned int textureSpecular;
+    unsigned int textureDiffuse = 0;
+    unsigned int textureSpecular = 0;
+    int lodLevel = 0;       // level of detail drawn last frame
 
-    void draw(Shader& shader, glm::vec3 viewPos);
+    glm::mat4 modelMatrix() const;
+    MaterialId material() const;
+    void draw(Shader& shader);
 };
 
 
 std::vector<Object> objects; // Global vector for all objects
-void Object::draw(Shader& shader, glm::vec3 viewPos) {
+glm::mat4 Object::modelMatrix() const {
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, position);
     model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
     model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
     model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
     model = glm::scale(model, scale);
-
-    shader.setMat4("model", model);
+    return model;
+}
+// material table entry the renderable draws with
+MaterialId Object::material() const {
+    switch (type) {
+    case SPHERETEX: return static_cast<SphereWithTexture*>(renderable)->material;
+    case CHEST: return static_cast<Chest*>(renderable)->material;
+    case CYLINDERTEX: return static_cast<CylinderWithTexture*>(renderable)->material;
+    case HEMISPHERETEX: return static_cast<HemiWithTex*>(renderable)->material;
+    case CURVETEX: return static_cast<CurveWithTexture*>(renderable)->material;
+    case CONETEX: return static_cast<ConeWithTexture*>(renderable)->material;
+    }
+    return MaterialTable::DEFAULT;
+}
+void Object::draw(Shader& shader) {
+    glm::mat4 model = modelMatrix();
 
     if (type == SPHERETEX) {
-        static_cast<SphereWithTexture*>(renderable)->drawSphere(shader, model, viewPos);
+        static_cast<SphereWithTexture*>(renderable)->drawSphere(shader, model, &lodLevel);
     }
     else if (type == CHEST) {
         static_cast<Chest*>(renderable)->drawCubeWithTwoTextures(shader, model);
     }
     else if (type == CYLINDERTEX) {
-        static_cast<CylinderWithTexture*>(renderable)->drawCylinder(shader, model, viewPos);
+        static_cast<CylinderWithTexture*>(renderable)->drawCylinder(shader, model, &lodLevel);
     }
     else if (type == HEMISPHERETEX) {
-        static_cast<HemiWithTex*>(renderable)->drawSphere(shader, model, viewPos);
+        static_cast<HemiWithTex*>(renderable)->drawSphere(shader, model, &lodLevel);
     }
     else if (type == CURVETEX) {
-        static_cast<CurveWithTexture*>(renderable)->render(shader, model, viewPos);
+        static_cast<CurveWithTexture*>(renderable)->render(shader, model, &lodLevel);
     }
     else if (type == CONETEX) {
-        static_cast<ConeWithTexture*>(renderable)->drawCone(shader, model, viewPos);
+        static_cast<ConeWithTexture*>(renderable)->drawCone(shader, model, &lodLevel);
     }
 }
 void initializeObjects(SphereWithTexture& globe, CylinderWithTexture& stoneObstacle, Chest& chestCube, HemiWithTex& hemiSphere, CurveWithTexture& vase,ConeWithTexture& selcone) {
@@ -367,12 +421,6 @@ void initializeObjects(SphereWithTexture& globe, CylinderWithTexture& stoneObsta
 
 
 glm::vec3 getTransformedPosition(const Object& obj);
-void drawBoundingSphere(Shader& shader, Object& obj) {
-    Sphere sphere;
-    glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), obj.position), glm::vec3(obj.boundingRadius));
-    shader.setMat4("model", model);
-    //sphere.drawSphere(shader,model); // Assume you have a wireframe sphere drawing utility
-}
 
 glm::vec3 TraceRay(double mouseX, double mouseY, int screenWidth, int screenHeight, glm::mat4 viewMatrix, glm::mat4 projectionMatrix) {
     // Convert mouse position to Normalized Device Coordinates (NDC)
@@ -520,6 +568,14 @@ bool firstFound = false; // Whether the key is found
 float firstTime = 0.0f;
 bool level1 = true; // Static targets level
 bool level2 = false;
+const double TEXTURE_UPLOAD_BUDGET_MS = 2.0; // per-frame time for uploading background-decoded textures
+const size_t TEXTURE_BUDGET_MB = 64;         // resident texture memory before least-recently-used textures are trimmed
+const float TEXTURE_ANISOTROPY = 4.0f;       // applied to every sampler object, clamped to the driver's maximum
+const int TEXTURE_STREAM_FIRST_SIZE = 64;    // baked textures show up at this size first, finer levels stream in later
+const bool PACKED_VERTICES = true;           // 16-byte vertices (half positions and uvs, octahedral normals) in the geometry arena
+const bool OPTIMIZE_MESHES = true;           // weld and reorder every mesh for the vertex cache before it is uploaded
+const bool TESSELLATE_ROUND_OBJECTS = true;  // spheres, cylinders and cones tessellated on the GPU when it supports GL 4.0
+const float TESSELLATION_PIXELS = 6.0f;      // on-screen length the tessellator aims for per segment
 
 
 // light settings
@@ -558,7 +614,26 @@ struct Arrow {
     void update(float deltaTime); // Update arrow position
 };
 Arrow arrow; // Single arrow object
-unsigned int trajectoryVAO, trajectoryVBO;
+
+// Shared meshes of the shooting level, looked up in the mesh registry once after the GL
+// context exists. They are const; each draw passes its own material.
+struct LevelMeshes {
+    const CylinderWithTexture* arrow = nullptr;
+    const CylinderWithTexture* target = nullptr;
+    const SphereWithTexture* trophyBase = nullptr;
+    const Chest* lostChest = nullptr;
+
+    void resolve() {
+        MeshRegistry& registry = MeshRegistry::instance();
+        arrow = &registry.cylinderWithTexture(0.8f, 0.8f, 2.0f, 50, 20);
+        target = &registry.cylinderWithTexture(1.0f, 1.0f, 0.2f, 36, 18);
+        trophyBase = &registry.sphereWithTexture(1.0f, 36, 18);
+        lostChest = &registry.chest();
+    }
+};
+LevelMeshes levelMeshes;
+GLVertexArray trajectoryVAO;
+GLBuffer trajectoryVBO;
 // Arrow Rendering Function
 void Arrow::draw(Shader& shader) {
     glm::mat4 model = glm::mat4(1.0f);
@@ -568,23 +643,19 @@ void Arrow::draw(Shader& shader) {
     //model = glm::rotate(model, glm::radians(-45.0f), glm::vec3(1.0, 0.0, 0.0));
     model = glm::rotate(model, glm::radians(270.0f), glm::vec3(0.0, 0.0, 1.0));
 
-    shader.setMat4("model", model);
-
     // Updated: Added a generic texture for the arrow
     unsigned int arrowTexture = loadTexture("container2.png", GL_REPEAT, GL_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);
 
-    CylinderWithTexture arrowTex(0.8f, 0.8f, 2.0f, 50, 20,
+    static const MaterialId arrowMaterial = MaterialTable::instance().add(
         glm::vec3(1.0f, 1.0f, 1.0f),  // Ambient color
         glm::vec3(1.0f, 1.0f, 1.0f),  // Diffuse color
         glm::vec3(0.2f, 0.2f, 0.2f),  // Specular color
-        32.0f,                        // Shininess
-        arrowTexture,                 // Diffuse texture
-        arrowTexture                  // Specular texture
+        32.0f                         // Shininess
     );
 
 
     // Draw the arrow cylinder
-    arrowTex.drawCylinder(shader, model, camera.Position);
+    levelMeshes.arrow->drawCylinder(shader, model, arrowMaterial, arrowTexture, arrowTexture);
 
 }
 
@@ -610,6 +681,8 @@ struct Target {
     bool isHit;           // Whether the target is hit
     float speed;          // Speed of the target's movement
     unsigned int textureID;  // Texture ID for the target
+    int lodLevel = 0;        // level of detail drawn last frame
+    glm::mat4 modelMatrix() const;
     void draw(Shader& shader);  // Render the target
     void update(float deltaTime); // Move the target
 
@@ -620,8 +693,22 @@ struct Target {
 };
 std::vector<Target> targets; // List of targets
 
+// textures of the shooting room and its second level (plus the win/lose screens), prefetched while room 0 is played
+const std::vector<PrefetchAsset> room1Assets = {
+    { "shoot133.jpg", GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR },
+    { "shoot133.jpg", GL_REPEAT, GL_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR },
+    { "container2.png", GL_REPEAT, GL_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR }
+};
+const std::vector<PrefetchAsset> level2Assets = {
+    { "gold.jpg", GL_REPEAT, GL_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR },
+    { "shoot2.jpg", GL_REPEAT, GL_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR }
+};
+
 // Updated initializeNextRoom Function
 void initializeNextRoom() {
+    AssetPrefetcher::instance().beginTransition("room 1");
+    GLObjectCounter::instance().expectLoading();
+
     // Arrow Initialization
 
 
@@ -643,6 +730,9 @@ void initializeNextRoom() {
 }
 
 void initializeNextRoom2() {
+    AssetPrefetcher::instance().beginTransition("level 2");
+    GLObjectCounter::instance().expectLoading();
+
     // Arrow Initialization
 
 
@@ -706,32 +796,51 @@ void renderTrajectory(Shader& shader, const std::vector<glm::vec3>& trajectoryPo
     glBindVertexArray(trajectoryVAO);
     glDrawArrays(GL_LINE_STRIP, 0, trajectoryPoints.size());
     glBindVertexArray(0);
+    GeometryArena::instance().invalidateBinding();
 }
 
-// Updated Target Drawing Function
-void Target::draw(Shader& shader) {
+glm::mat4 Target::modelMatrix() const {
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, position);
     model = glm::scale(model, glm::vec3(radius * 2.0f));
     // Add continuous rotation around the z-axis
     //float rotationAngle = glfwGetTime() * 50.0f; // Adjust speed by changing 50.0f
     model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)); 
+    return model;
+}
 
-
-    shader.setMat4("model", model);
-
-    
-    CylinderWithTexture targetSphere(1.0f,1.0f,0.2f, 36, 18,
+// every target shares one material
+static MaterialId targetMaterial() {
+    static const MaterialId id = MaterialTable::instance().add(
         glm::vec3(0.1f, 0.1f, 0.8f),
         glm::vec3(0.2f, 0.2f, 0.9f),
         glm::vec3(0.1f, 0.1f, 0.1f),
-        32.0f,
-        textureID,
-        textureID
-    );
-    
+        32.0f);
+    return id;
+}
+
+// Updated Target Drawing Function
+void Target::draw(Shader& shader) {
+    glm::mat4 model = modelMatrix();
 
-    targetSphere.drawCylinder(shader, model, camera.Position);
+    levelMeshes.target->drawCylinder(shader, model, targetMaterial(), textureID, textureID, &lodLevel);
+}
+
+// Targets still standing, their model matrices sent in one upload
+void drawTargets(Shader& shader) {
+    DrawBatch targetDraws;
+    for (const Target& target : targets) {
+        if (!target.isHit)
+            targetDraws.add(target.modelMatrix(), targetMaterial());
+    }
+    targetDraws.write();
+    size_t drawn = 0;
+    for (Target& target : targets) {
+        if (!target.isHit) {
+            targetDraws.bind(drawn++);
+            target.draw(shader);
+        }
+    }
 }
 void Target::update(float deltaTime) {
     if (!isHit) {
@@ -775,8 +884,8 @@ std::vector<glm::vec3> generateTrajectoryPoints(glm::vec3 start, glm::vec3 direc
 
 
 void setupTrajectory() {
-    glGenVertexArrays(1, &trajectoryVAO);
-    glGenBuffers(1, &trajectoryVBO);
+    trajectoryVAO = GLVertexArray::create(GL_HERE);
+    trajectoryVBO = GLBuffer::create(GL_HERE);
 
     glBindVertexArray(trajectoryVAO);
     glBindBuffer(GL_ARRAY_BUFFER, trajectoryVBO);
@@ -786,11 +895,13 @@ void setupTrajectory() {
     glEnableVertexAttribArray(0);
 
     glBindVertexArray(0);
+    GeometryArena::instance().invalidateBinding();
 }
 
 void updateTrajectoryBuffer(const std::vector<glm::vec3>& trajectoryPoints) {
     glBindBuffer(GL_ARRAY_BUFFER, trajectoryVBO); // trajectoryVBO is the VBO ID for trajectory
     glBufferData(GL_ARRAY_BUFFER, trajectoryPoints.size() * sizeof(glm::vec3), trajectoryPoints.data(), GL_DYNAMIC_DRAW);
+    trajectoryVBO.setBytes(trajectoryPoints.size() * sizeof(glm::vec3));
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
@@ -820,6 +931,7 @@ void checkGameStatus() {
         else if (score == 40 && level2) {
             // End game if all moving targets are hit
             gameOver = true;
+            GLObjectCounter::instance().expectLoading(); // the trophy's gold.jpg is loaded the first time it is drawn
             std::cout << "All targets hit in Level 2! You win!" << std::endl;
             allTargetsHit = true;
 
@@ -832,6 +944,7 @@ void checkGameStatus() {
 
         if (elapsedTime > 38.0f) { // 30 seconds timeout
             gameOver = true;
+            GLObjectCounter::instance().expectLoading(); // the lost chest's shoot2.jpg is loaded the first time it is drawn
             allTargetsHit = false;
             std::cout << "Game over! You ran out of time!" << std::endl;
         }
@@ -853,8 +966,51 @@ void checkGameStatus() {
 
 
 
-int main()
+int main(int argc, char** argv)
 {
+    // offline converter: main --bake-textures [--bc | --bc7] concrete.jpg vinci.jpg ...
+    // writes <image>.thtx next to each image; loadTexture() picks those up automatically.
+    // --bc stores BC1/BC3 blocks, --bc7 BC7 blocks, otherwise the levels stay uncompressed
+    if (argc > 1 && std::string(argv[1]) == "--bake-textures")
+    {
+        TextureCompression compression = TEXTURE_COMPRESSION_NONE;
+        int failed = 0;
+        for (int i = 2; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--bc")
+                compression = TEXTURE_COMPRESSION_S3TC;
+            else if (arg == "--bc7")
+                compression = TEXTURE_COMPRESSION_BPTC;
+            else if (!bakeTextureContainer(arg, textureContainerPath(arg), compression))
+                ++failed;
+        }
+        return failed == 0 ? 0 : 1;
+    }
+
+    // offline converter: main --bake-meshes verticesVase.txt indicesVase.txt verticesTex.txt indicesTex.txt
+    // writes <vertices>.thmesh for each vertex/index file pair; CurveWithTexture picks those up.
+    if (argc > 1 && std::string(argv[1]) == "--bake-meshes")
+    {
+        if ((argc - 2) % 2 != 0)
+        {
+            std::cerr << "--bake-meshes takes vertex and index files in pairs" << std::endl;
+            return 1;
+        }
+        int failed = 0;
+        for (int i = 2; i + 1 < argc; i += 2)
+            if (!bakeMeshContainer(argv[i], argv[i + 1], meshContainerPath(argv[i])))
+                ++failed;
+        return failed == 0 ? 0 : 1;
+    }
+
+    // main --bench-mesh-load [vertices]: text stream vs from_chars vs mapped container (default 1M vertices)
+    if (argc > 1 && std::string(argv[1]) == "--bench-mesh-load")
+    {
+        benchmarkMeshLoading(argc > 2 ? (size_t)atol(argv[2]) : 1000000);
+        return 0;
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -893,10 +1049,43 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // from here on every glGen* call is counted, so per-frame object creation shows up
+    GLObjectCounter::instance().install();
+    GeometryArena::instance().setPackedVertices(PACKED_VERTICES);
+    GeometryArena::instance().setOptimizeMeshes(OPTIMIZE_MESHES);
+    LodSelector::instance().setViewportHeight(SCR_HEIGHT);
+    // camera and point lights for every lighting program, one uniform buffer write per frame
+    FrameUniforms::instance().init();
+    // model matrices of every draw, streamed through a ring of per-frame regions
+    DrawUniforms::instance().init((GLADloadproc)glfwGetProcAddress);
+    // every material registered so far, uploaded once; draws only carry its index
+    MaterialTable::instance().init();
+
+    // main --bench-normal-matrix [vertices] [draws]: GPU time of normal matrices per vertex vs per draw
+    if (argc > 1 && std::string(argv[1]) == "--bench-normal-matrix")
+    {
+        benchmarkNormalMatrix(argc > 2 ? (size_t)atol(argv[2]) : 6000, argc > 3 ? (size_t)atol(argv[3]) : 1000);
+        MaterialTable::instance().release();
+        DrawUniforms::instance().release();
+        FrameUniforms::instance().release();
+        GLObjectRegistry::instance().contextDestroyed();
+        glfwTerminate();
+        return 0;
+    }
+    // the shooting level draws shared registry meshes; find them once, not per frame
+    levelMeshes.resolve();
+    // GL 4.0 tessellation for the round objects; without it they keep drawing their meshes
+    if (TESSELLATE_ROUND_OBJECTS)
+        TessellatedSurfaces::instance().init((GLADloadproc)glfwGetProcAddress);
+    TessellatedSurfaces::instance().pixelsPerSegment = TESSELLATION_PIXELS;
+    TessellatedSurfaces::instance().setViewportHeight(SCR_HEIGHT);
 
     // configure global opengl state
     // -----------------------------
     glEnable(GL_DEPTH_TEST);
+    TextureCache::instance().setBudget(TEXTURE_BUDGET_MB * 1024 * 1024);
+    TextureCache::instance().samplerCache().setDefaultAnisotropy(TEXTURE_ANISOTROPY);
+    TextureCache::instance().setStreaming(true, TEXTURE_STREAM_FIRST_SIZE);
 
     // build and compile our shader zprogram
     // ------------------------------------
@@ -904,104 +1093,9 @@ int main()
     //Shader lightingShader("vertexShaderForGouraudShading.vs", "fragmentShaderForGouraudShading.fs");
     Shader ourShader("vertexShader.vs", "fragmentShader.fs");
 
-    // set up vertex data (and buffer(s)) and configure vertex attributes
-    // ------------------------------------------------------------------
-
-    float cube_vertices[] = {
-        // Positions          // Normals
-        // Front face
-        0.0f, 0.0f, 0.5f,     0.0f, 0.0f, 1.0f,
-        0.5f, 0.0f, 0.5f,     0.0f, 0.0f, 1.0f,
-        0.5f, 0.5f, 0.5f,     0.0f, 0.0f, 1.0f,
-        0.0f, 0.5f, 0.5f,     0.0f, 0.0f, 1.0f,
-
-        // Back face
-        0.0f, 0.0f, 0.0f,     0.0f, 0.0f, -1.0f,
-        0.5f, 0.0f, 0.0f,     0.0f, 0.0f, -1.0f,
-        0.5f, 0.5f, 0.0f,     0.0f, 0.0f, -1.0f,
-        0.0f, 0.5f, 0.0f,     0.0f, 0.0f, -1.0f,
-
-        // Left face
-        0.0f, 0.0f, 0.0f,     -1.0f, 0.0f, 0.0f,
-        0.0f, 0.0f, 0.5f,     -1.0f, 0.0f, 0.0f,
-        0.0f, 0.5f, 0.5f,     -1.0f, 0.0f, 0.0f,
-        0.0f, 0.5f, 0.0f,     -1.0f, 0.0f, 0.0f,
-
-        // Right face
-        0.5f, 0.0f, 0.0f,     1.0f, 0.0f, 0.0f,
-        0.5f, 0.0f, 0.5f,     1.0f, 0.0f, 0.0f,
-        0.5f, 0.5f, 0.5f,     1.0f, 0.0f, 0.0f,
-        0.5f, 0.5f, 0.0f,     1.0f, 0.0f, 0.0f,
-
-        // Top face
-        0.0f, 0.5f, 0.0f,     0.0f, 1.0f, 0.0f,
-        0.5f, 0.5f, 0.0f,     0.0f, 1.0f, 0.0f,
-        0.5f, 0.5f, 0.5f,     0.0f, 1.0f, 0.0f,
-        0.0f, 0.5f, 0.5f,     0.0f, 1.0f, 0.0f,
-
-        // Bottom face
-        0.0f, 0.0f, 0.0f,     0.0f, -1.0f, 0.0f,
-        0.5f, 0.0f, 0.0f,     0.0f, -1.0f, 0.0f,
-        0.5f, 0.0f, 0.5f,     0.0f, -1.0f, 0.0f,
-        0.0f, 0.0f, 0.5f,     0.0f, -1.0f, 0.0f,
-    };
-
-
-     
-
-
-    unsigned int cube_indices[] = {
-        0, 3, 2,
-        2, 1, 0,
-
-        4, 5, 7,
-        7, 6, 4,
-
-        8, 9, 10,
-        10, 11, 8,
-
-        12, 13, 14,
-        14, 15, 12,
-
-        16, 17, 18,
-        18, 19, 16,
-
-        20, 21, 22,
-        22, 23, 20
-    };
-
-    unsigned int cubeVAO, cubeVBO, cubeEBO;
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &cubeVBO);
-    glGenBuffers(1, &cubeEBO);
-
-    glBindVertexArray(cubeVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cube_indices), cube_indices, GL_STATIC_DRAW);
-
-
-    // position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // vertex normal attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)12);
-    glEnableVertexAttribArray(1);
-
-    // second, configure the light's VAO (VBO stays the same; the vertices are the same for the light object which is also a 3D cube)
-    unsigned int lightCubeVAO;
-    glGenVertexArrays(1, &lightCubeVAO);
-    glBindVertexArray(lightCubeVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeEBO);
-    // note that we update the lamp's position attribute's stride to reflect the updated buffer data
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    // the room cube is the unit box every Cube and Chest shares (boxGeometry.h), drawn at half
+    // size by the classroom's CubeDraws; it also draws the lamps, whose shader only reads the position
+    const ArenaMesh& cubeMesh = BoxGeometry::instance().acquire(BoxShape::Box);
 
 
 
@@ -1030,6 +1124,21 @@ int main()
     //Shader ourShader("vertexShader.vs", "fragmentShader.fs");
     Shader fragmentBlendingShader("vertexShaderForPhongShadingWithTexture.vs", "fragmentShaderForPhongShadingWithTexture.fs");
     Shader vertexBlendingShader("vertexShaderWithTexture.vs", "fragmentShaderWithoutTexture.fs");
+    MaterialTextureArray::attach(lightingShaderWithTexture);
+    MaterialTextureArray::attach(fragmentBlendingShader);
+    MaterialTextureArray::attach(vertexBlendingShader);
+    // every lighting program reads the camera and point lights from the frame uniform block,
+    // its model matrix and material index from the per-draw uniform buffer and the material
+    // from the material table
+    for (Shader* shader : { &lightingShader, &ourShader, &lightingShaderWithTexture, &fragmentBlendingShader, &vertexBlendingShader })
+    {
+        FrameUniforms::attach(*shader);
+        DrawUniforms::attach(*shader);
+        MaterialTable::attach(*shader);
+    }
+    // the tessellated round objects share their fragment shader
+    TessellatedSurfaces::instance().pairWith(lightingShaderWithTexture);
+    TessellatedSurfaces::instance().pairWith(fragmentBlendingShader);
 
 
     // Assuming you have a shader initialized
@@ -1213,6 +1322,15 @@ int main()
 
     initializeObjects(globe, stoneObstacle, chestCube, gold, vase,selcone);
 
+    // textures were decoded in the background while the scene was set up; upload the rest now
+    TextureCache::instance().finishPending();
+
+    // the next room's textures load in the background while this one is played
+    // everything loaded so far belongs to room 0; the prefetched textures belong to room 1
+    TextureCache::instance().assignUnassigned(0);
+    AssetPrefetcher::instance().prefetch("room 1", 1, room1Assets);
+    AssetPrefetcher::instance().prefetch("level 2", 1, level2Assets);
+
 
 
 
@@ -1237,11 +1355,22 @@ int main()
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        AssetPrefetcher::instance().frameFinished(deltaTime * 1000.0);
 
         // input
         // -----
         processInput(window);
         float currentTime = glfwGetTime();
+
+        // residency: advance the LRU clock and trim to the memory budget
+        TextureCache::instance().beginFrame();
+
+        // upload textures requested mid-game once their background decode has finished,
+        // a few per frame so a burst of prefetched images does not cause a hitch
+        TextureCache::instance().pumpUploads(TEXTURE_UPLOAD_BUDGET_MS);
+        MaterialTextureArray::instance().bindForFrame();
+        // per-draw uniforms go to the next region of the ring, once the GPU is done with it
+        DrawUniforms::instance().beginFrame();
         // render
         // ------
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);  // Set background color to black
@@ -1252,12 +1381,6 @@ int main()
 
         // be sure to activate shader when setting uniforms/drawing objects
         lightingShader.use();
-        lightingShader.setVec3("viewPos", camera.Position);
-
-        // point light 1
-        pointlight1.setUpPointLight(lightingShader, currentTime);
-        // point light 2
-        pointlight2.setUpPointLight(lightingShader, currentTime);
 
         spotlight.setUpSpotLight(lightingShader);
         directionallight.setUpDirectionalLight(lightingShader);
@@ -1282,16 +1405,21 @@ int main()
 
         projection = PerspectiveProjection(fov, aspect, near, far);
 
-        lightingShader.setMat4("projection", projection);
-
         //glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
         //glm::mat4 projection = glm::ortho(-2.0f, +2.0f, -1.5f, +1.5f, 0.1f, 100.0f);
-        lightingShader.setMat4("projection", projection);
 
         // camera/view transformation
         //glm::mat4 view = camera.GetViewMatrix();
         glm::mat4 view = basic_camera.createViewMatrix();
-        lightingShader.setMat4("view", view);
+
+        // camera and point lights for every program, in one buffer write; switching shaders
+        // or blending modes below sends none of them again
+        FrameUniforms& frame = FrameUniforms::instance();
+        frame.setCamera(projection, view, camera.Position);
+        pointlight1.setUpFrameLight(frame.data.lights[0], pointOn1, currentTime);
+        pointlight2.setUpFrameLight(frame.data.lights[1], pointOn2, currentTime);
+        frame.upload();
+        LodSelector::instance().setView(view, projection);
         if (currentRoom == 0) {
 
             // Modelling Transformation
@@ -1303,13 +1431,12 @@ int main()
             rotateZMatrix = glm::rotate(identityMatrix, glm::radians(rotateAngle_Z), glm::vec3(0.0f, 0.0f, 1.0f));
             scaleMatrix = glm::scale(identityMatrix, glm::vec3(scale_X, scale_Y, scale_Z));
             model = translateMatrix * rotateXMatrix * rotateYMatrix * rotateZMatrix * scaleMatrix;
-            lightingShader.setMat4("model", model);
 
             //glBindVertexArray(cubeVAO);
             //glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
             //glDrawArrays(GL_TRIANGLES, 0, 36);
 
-            classroom(cubeVAO, lightingShader, model);
+            classroom(cubeMesh, lightingShader, model);
 
             //bed(cubeVAO, lightingShader, model);
             //glm::mat4 translateMatrix, rotateXMatrix, rotateYMatrix, rotateZMatrix, scaleMatrix;
@@ -1323,7 +1450,7 @@ int main()
           translateMatrix = glm::translate(model, glm::vec3(-2.8f, 1.2f, -8.5f));
             scaleMatrix = glm::scale(translateMatrix, glm::vec3(0.150f, 0.150f, 0.150f));
 
-            globe.drawSphere(lightingShader, scaleMatrix,camera.Position);
+            globe.drawSphere(lightingShader, scaleMatrix);
 
             //globe handle
 
@@ -1366,19 +1493,22 @@ int main()
 
             // also draw the lamp object(s)
             ourShader.use();
-            ourShader.setMat4("projection", projection);
-            ourShader.setMat4("view", view);
 
             // we now draw as many light bulbs as we have point lights.
-            glBindVertexArray(lightCubeVAO);
+            DrawBatch lampDraws;
             for (unsigned int i = 0; i < 2; i++)
             {
                 model = glm::mat4(1.0f);
                 model = glm::translate(model, pointLightPositions[i]);
-                model = glm::scale(model, glm::vec3(0.2f)); // Make it a smaller cube
-                ourShader.setMat4("model", model);
+                model = glm::scale(model, glm::vec3(0.1f)); // Make it a smaller cube (a fifth of the 0.5 room cube)
+                lampDraws.add(model);
+            }
+            lampDraws.write();
+            for (unsigned int i = 0; i < 2; i++)
+            {
+                lampDraws.bind(i);
                 ourShader.setVec3("color", glm::vec3(0.8f, 0.8f, 0.8f));
-                glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+                GeometryArena::instance().draw(cubeMesh);
                 //glDrawArrays(GL_TRIANGLES, 0, 36);
             }
            
@@ -1436,8 +1566,6 @@ int main()
                 lightingShaderWithTexture.use();
 
             }
-            activeShader->setBool("pointLightEnabled[0]", pointOn1);
-            activeShader->setBool("pointLightEnabled[1]", pointOn2);
             //activeShader->setVec3("globalAmbientLight", glm::vec3(0.8f, 0.8f, 0.8f));
 
             if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS && !key2Pressed) {
@@ -1464,18 +1592,11 @@ int main()
             }*/
 
 
-            // Set common uniforms for the active shader
-            activeShader->setVec3("viewPos", camera.Position);
-            activeShader->setMat4("projection", projection);
-            activeShader->setMat4("view", view);
-
-            // Configure lights for the active shader
-            pointlight1.setUpPointLight2(*activeShader, pointOn1, currentTime);
-            pointlight2.setUpPointLight2(*activeShader, pointOn2, currentTime);
+            // camera and point lights (including the switches above, from next frame) come from
+            // the frame uniform block
             //spotlight.setUpSpotLight(*activeShader);
             //directionallight.setUpDirectionalLight();
 
-            glm::vec3 viewPos = camera.Position; // Assuming you have a camera object
             unsigned int textureDiffuse = globeDiffuseMap; // Replace with actual diffuse texture
             unsigned int textureSpecular = globeSpecularMap; // Replace with actual specular texture
 
@@ -1483,11 +1604,16 @@ int main()
 
 
 
-            // Render objects using the active shader
+            // Render objects using the active shader, their model matrices sent in one upload
             // 
-            for (Object& obj : objects) {
-                obj.draw(*activeShader, viewPos);
-                drawBoundingSphere(*activeShader, obj);
+            DrawBatch objectDraws;
+            for (const Object& obj : objects)
+                objectDraws.add(obj.modelMatrix(), obj.material());
+            objectDraws.write();
+            for (size_t i = 0; i < objects.size(); ++i) {
+                Object& obj = objects[i];
+                objectDraws.bind(i);
+                obj.draw(*activeShader);
 
             }
            
@@ -1600,8 +1726,7 @@ int main()
             model4 = glm::scale(model4, glm::vec3(0.4f, 0.6f, 0.4f));     // Scale the object
 
             // Render the curve
-            viewPos = camera.Position; // Replace with your actual camera position
-            curve.render(*activeShader, model4, viewPos);
+            curve.render(*activeShader, model4);
 
 
             /* // Define animation parameters
@@ -1739,6 +1864,7 @@ int main()
                 if (glfwGetTime() - keyFoundTime > 1.0f) { // 1-second delay
                     transitioning = true;
                     currentRoom = 1; // Switch to the next room
+                    TextureCache::instance().enterRoom(currentRoom);
                     initializeNextRoom();
                     std::cout << "Transitioning to the next room..." << std::endl;
                 }
@@ -1750,8 +1876,6 @@ int main()
         }
         if (currentRoom == 1) {
             lightingShaderWithTexture.use();
-            lightingShaderWithTexture.setMat4("projection", projection);
-            lightingShaderWithTexture.setMat4("view", view);
 
             // Check for mouse click to shoot arrow
             if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
@@ -1761,10 +1885,10 @@ int main()
             // Check game status and render based on level
             checkGameStatus();
             if (level1) {
-                renderLevel2(lightingShaderWithTexture, window, view, projection); // Level 1 rendering
+                renderLevel2(lightingShaderWithTexture, window); // Level 1 rendering
             }
             else if (level2) {
-                renderLevel1(lightingShaderWithTexture, window, view, projection); // Level 2 rendering
+                renderLevel1(lightingShaderWithTexture, window); // Level 2 rendering
             }
         }
 
@@ -1777,16 +1901,42 @@ int main()
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
         glfwPollEvents();
+        GLObjectCounter::instance().endFrame();
+        GeometryArena::instance().endFrame();
+        LodSelector::instance().endFrame();
+        TessellatedSurfaces::instance().endFrame();
+        UniformCounter::instance().endFrame();
+        DrawUniforms::instance().endFrame();
     }
 
 
 
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
-    glDeleteVertexArrays(1, &cubeVAO);
-    glDeleteVertexArrays(1, &lightCubeVAO);
-    glDeleteBuffers(1, &cubeVBO);
-    glDeleteBuffers(1, &cubeEBO);
+    BoxGeometry::instance().release(BoxShape::Box);
+
+    MaterialTextureArray::instance().release();
+    TessellatedSurfaces::instance().release();
+    FrameUniforms::instance().release();
+    DrawUniforms::instance().release();
+    MaterialTable::instance().release();
+    AssetPrefetcher::instance().release();
+    TextureCache::instance().printStats();
+    TextureCache::instance().clear();
+    MeshRegistry::instance().printStats();
+    MeshRegistry::instance().clear();
+    BoxGeometry::instance().printStats();
+    BoxGeometry::instance().clear();
+    GeometryArena::instance().printStats();
+    GeometryArena::instance().clear();
+    MeshOptimizer::instance().printReport();
+    GLObjectCounter::instance().printStats();
+    trajectoryVAO.reset();
+    trajectoryVBO.reset();
+    GLObjectRegistry::instance().printLive();
+
+    // locals of main() (shaders, the chest) are destroyed after this; the context deletes their objects
+    GLObjectRegistry::instance().contextDestroyed();
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -1794,19 +1944,12 @@ int main()
     return 0;
 }
 
-void drawCube(unsigned int& cubeVAO, Shader& lightingShader, glm::mat4 model = glm::mat4(1.0f), float r = 1.0f, float g = 1.0f, float b = 1.0f, float a = 1.0f)
+void drawCube(CubeDraws& cubes, glm::mat4 model = glm::mat4(1.0f), float r = 1.0f, float g = 1.0f, float b = 1.0f, int times = 1)
 {
-    lightingShader.use();
-
-    lightingShader.setVec3("material.ambient", glm::vec4(r, g, b, a));
-    lightingShader.setVec3("material.diffuse", glm::vec4(r, g, b, a));
-    lightingShader.setVec3("material.specular", glm::vec3(0.1, 0.1, 0.1));
-    lightingShader.setFloat("material.shininess", 32.0f);
+    // registered the first time, looked up after that
+    MaterialId material = MaterialTable::instance().add(glm::vec3(r, g, b), glm::vec3(r, g, b), glm::vec3(0.1f), 32.0f);
 
-    lightingShader.setMat4("model", model);
-
-    glBindVertexArray(cubeVAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+    cubes.add(model, material, times);
 }
 
 
@@ -2064,6 +2207,80 @@ void processInput(GLFWwindow* window)
         key7Pressed = false;
     }
 
+    // Print texture cache statistics (F1)
+    static bool keyF1Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS) {
+        if (!keyF1Pressed) {
+            keyF1Pressed = true;
+            TextureCache::instance().printStats();
+            MeshRegistry::instance().printStats();
+            BoxGeometry::instance().printStats();
+            GeometryArena::instance().printStats();
+            MeshOptimizer::instance().printReport();
+            LodSelector::instance().printStats();
+            UniformCounter::instance().printStats();
+            FrameUniforms::instance().printStats();
+            DrawUniforms::instance().printStats();
+            MaterialTable::instance().printStats();
+            TessellatedSurfaces::instance().printStats();
+            GLObjectCounter::instance().printStats();
+            GLObjectRegistry::instance().printLive();
+        }
+    }
+    else if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_RELEASE) {
+        keyF1Pressed = false;
+    }
+
+    // Dump resident textures (F3)
+    static bool keyF3Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS) {
+        if (!keyF3Pressed) {
+            keyF3Pressed = true;
+            TextureCache::instance().dumpResident();
+        }
+    }
+    else if (glfwGetKey(window, GLFW_KEY_F3) == GLFW_RELEASE) {
+        keyF3Pressed = false;
+    }
+
+    // Toggle texture array materials (F2)
+    static bool keyF2Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS) {
+        if (!keyF2Pressed) {
+            keyF2Pressed = true;
+            MaterialTextureArray::instance().toggle();
+        }
+    }
+    else if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_RELEASE) {
+        keyF2Pressed = false;
+    }
+
+    // Toggle level of detail (F4); F1 shows the triangles submitted with the current setting
+    static bool keyF4Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F4) == GLFW_PRESS) {
+        if (!keyF4Pressed) {
+            keyF4Pressed = true;
+            LodSelector::instance().enabled = !LodSelector::instance().enabled;
+            std::cout << "Level of detail " << (LodSelector::instance().enabled ? "on" : "off") << std::endl;
+        }
+    }
+    else if (glfwGetKey(window, GLFW_KEY_F4) == GLFW_RELEASE) {
+        keyF4Pressed = false;
+    }
+
+    // Toggle hardware tessellation of the round objects (F5); off, they draw their meshes
+    static bool keyF5Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F5) == GLFW_PRESS) {
+        if (!keyF5Pressed) {
+            keyF5Pressed = true;
+            TessellatedSurfaces::instance().enabled = !TessellatedSurfaces::instance().enabled;
+            TessellatedSurfaces::instance().printStats();
+        }
+    }
+    else if (glfwGetKey(window, GLFW_KEY_F5) == GLFW_RELEASE) {
+        keyF5Pressed = false;
+    }
+
 
     
 
@@ -2079,6 +2296,8 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     // make sure the viewport matches the new window dimensions; note that width and
     // height will be significantly larger than specified on retina displays.
     glViewport(0, 0, width, height);
+    LodSelector::instance().setViewportHeight(height);
+    TessellatedSurfaces::instance().setViewportHeight(height);
 }
 
 
@@ -2150,76 +2369,54 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
-void drawTableChair(Shader& shaderProgram, unsigned int VAO, glm::mat4 parentTrans)
+void drawTableChair(CubeDraws& cubes, glm::mat4 parentTrans)
 {
-    shaderProgram.use();
     glm::mat4 identityMatrix = glm::mat4(1.0f);
     glm::mat4 translateMatrix, rotateXMatrix, rotateYMatrix, rotateZMatrix, scaleMatrix, model, modelCentered;
 
+    // every piece of the table and chair is drawn twice, as it always has been
     //table 
     model = parentTrans * glm::scale(identityMatrix, glm::vec3(3.5f, 0.2f, 2.0f));
-    drawCube(VAO, shaderProgram, model, 0.9176f, 0.7020f, 0.0314f);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+    drawCube(cubes, model, 0.9176f, 0.7020f, 0.0314f, 2);
     model = parentTrans * glm::scale(identityMatrix, glm::vec3(0.2f, -2.0f, 0.2f));
-    drawCube(VAO, shaderProgram, model, 0.9176f, 0.7020f, 0.0314f);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+    drawCube(cubes, model, 0.9176f, 0.7020f, 0.0314f, 2);
 
 
     translateMatrix = glm::translate(identityMatrix, glm::vec3(0.0, 0.0, 0.9));
     model = parentTrans * glm::scale(translateMatrix, glm::vec3(0.2f, -2.0f, 0.2f));
-    drawCube(VAO, shaderProgram, model, 0.9176f, 0.7020f, 0.0314f);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+    drawCube(cubes, model, 0.9176f, 0.7020f, 0.0314f, 2);
 
     translateMatrix = glm::translate(identityMatrix, glm::vec3(1.65, 0.0, 0.9));
     model = parentTrans * glm::scale(translateMatrix, glm::vec3(0.2f, -2.0f, 0.2f));
-    drawCube(VAO, shaderProgram, model, 0.9176f, 0.7020f, 0.0314f);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+    drawCube(cubes, model, 0.9176f, 0.7020f, 0.0314f, 2);
 
     translateMatrix = glm::translate(identityMatrix, glm::vec3(1.65, 0.0, 0.0));
     model = parentTrans * glm::scale(translateMatrix, glm::vec3(0.2f, -2.0f, 0.2f));
-    drawCube(VAO, shaderProgram, model, 0.9176f, 0.7020f, 0.0314f);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+    drawCube(cubes, model, 0.9176f, 0.7020f, 0.0314f, 2);
 
 
     translateMatrix = glm::translate(identityMatrix, glm::vec3(0.55f, 0.1f, 0.50f));
     model = parentTrans * glm::scale(translateMatrix, glm::vec3(1.0f, 0.1f, 1.0f));
-    drawCube(VAO, shaderProgram, model, 0.0f, 0.0f, 0.0f);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+    drawCube(cubes, model, 0.0f, 0.0f, 0.0f, 2);
 
 
     translateMatrix = glm::translate(identityMatrix, glm::vec3(0.67f, 0.15f, 0.75f));
     model = parentTrans * glm::scale(translateMatrix, glm::vec3(0.5f, 0.1f, 0.50f));
-    drawCube(VAO, shaderProgram, model, 1.0f, 1.0f, 1.0f);
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+    drawCube(cubes, model, 1.0f, 1.0f, 1.0f, 2);
   
 
 
 }
-void MaterialSpec(unsigned int& cubeVAO, Shader& lightingShader, glm::mat4 model = glm::mat4(1.0f), float ra = 1.0f, float ga = 1.0f, float ba = 1.0f, float rd = 1.0f, float gd = 1.0f, float bd = 1.0f, float rs = 1.0f, float gs = 1.0f, float bs = 1.0f, float shininess = 32.0f, float re = 0.0f, float ge = 0.0f, float be = 0.3f)
+void MaterialSpec(CubeDraws& cubes, glm::mat4 model = glm::mat4(1.0f), float ra = 1.0f, float ga = 1.0f, float ba = 1.0f, float rd = 1.0f, float gd = 1.0f, float bd = 1.0f, float rs = 1.0f, float gs = 1.0f, float bs = 1.0f, float shininess = 32.0f, float re = 0.0f, float ge = 0.0f, float be = 0.3f)
 {
-    lightingShader.use();
-
-    lightingShader.setVec3("material.ambient", glm::vec3(ra, ga, ba));
-    lightingShader.setVec3("material.diffuse", glm::vec3(rd, gd, bd));
-    lightingShader.setVec3("material.specular", glm::vec3(rs, gs, bs));
-    lightingShader.setFloat("material.shininess", shininess);
-    lightingShader.setVec3("material.emissive", glm::vec3(re, ge, be));
+    MaterialId material = MaterialTable::instance().add(glm::vec3(ra, ga, ba), glm::vec3(rd, gd, bd), glm::vec3(rs, gs, bs),
+        shininess, glm::vec3(re, ge, be));
 
-    lightingShader.setMat4("model", model);
-
-    glBindVertexArray(cubeVAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+    cubes.add(model, material);
 
 }
 
-void DrawRoom(Shader& shaderProgram, unsigned int VAO, glm::mat4 model) {
+void DrawRoom(CubeDraws& cubes, glm::mat4 model) {
     glm::mat4 identityMatrix = glm::mat4(1.0f);
 
 
@@ -2227,8 +2424,7 @@ void DrawRoom(Shader& shaderProgram, unsigned int VAO, glm::mat4 model) {
     floorTransform = glm::scale(floorTransform, glm::vec3(15.0f, 0.1f, 20.5f)); // Large floor
     floorTransform = floorTransform * model;
     MaterialSpec(
-        VAO,
-        shaderProgram,
+        cubes,
         floorTransform,
         0.2f, 0.1f, 0.05f, // Ambient: ra, ga, ba
         0.4f, 0.2f, 0.1f,  // Diffuse: rd, gd, bd
@@ -2246,8 +2442,7 @@ void DrawRoom(Shader& shaderProgram, unsigned int VAO, glm::mat4 model) {
 
 
     MaterialSpec(
-        VAO,
-        shaderProgram,
+        cubes,
         scaleMatrix,
         0.3f, 0.3f, 0.3f, // Ambient: ra, ga, ba
         0.5f, 0.5f, 0.5f, // Diffuse: rd, gd, bd
@@ -2263,8 +2458,7 @@ void DrawRoom(Shader& shaderProgram, unsigned int VAO, glm::mat4 model) {
     leftWallTransform = glm::scale(leftWallTransform, glm::vec3(0.1f, 5.0f, 20.5f));
     leftWallTransform = leftWallTransform * model;
     MaterialSpec(
-        VAO,
-        shaderProgram,
+        cubes,
         leftWallTransform,
         0.8f, 0.8f, 0.8f, // Ambient: ra, ga, ba
         1.0f, 1.0f, 1.0f, // Diffuse: rd, gd, bd
@@ -2280,8 +2474,7 @@ void DrawRoom(Shader& shaderProgram, unsigned int VAO, glm::mat4 model) {
     rightWallTransform = glm::scale(rightWallTransform, glm::vec3(0.1f, 5.0f, 20.5)); // Wall dimensions
     rightWallTransform = rightWallTransform * model;
     MaterialSpec(
-        VAO,
-        shaderProgram,
+        cubes,
         rightWallTransform,
         0.8f, 0.8f, 0.8f, // Ambient: ra, ga, ba
         1.0f, 1.0f, 1.0f, // Diffuse: rd, gd, bd
@@ -2298,13 +2491,14 @@ void DrawRoom(Shader& shaderProgram, unsigned int VAO, glm::mat4 model) {
 
 
 
-void classroom(unsigned int& cubeVAO, Shader& lightingShader, glm::mat4 model)
+void classroom(const ArenaMesh& cubeMesh, Shader& lightingShader, glm::mat4 model)
 {
     glm::mat4 identityMatrix = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first
     glm::mat4 translateMatrix, rotateXMatrix, rotateYMatrix, rotateZMatrix, scaleMatrix;
 
 
-    DrawRoom(lightingShader, cubeVAO, model);
+    CubeDraws cubes;
+    DrawRoom(cubes, model);
 
     
 
@@ -2315,7 +2509,7 @@ void classroom(unsigned int& cubeVAO, Shader& lightingShader, glm::mat4 model)
  
     translateMatrix = glm::translate(identityMatrix, glm::vec3(-3.8f, 0.3f, -8.3f));
     mat = translateMatrix * glm::scale(glm::mat4(0.8f), glm::vec3(1.0f,0.8f,1.0f));
-    drawTableChair(lightingShader, cubeVAO, mat);
+    drawTableChair(cubes, mat);
     mat = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f));
     scaleMatrix = glm::scale(mat, glm::vec3(0.50f, 0.50f, 0.50f));
 
@@ -2324,49 +2518,16 @@ void classroom(unsigned int& cubeVAO, Shader& lightingShader, glm::mat4 model)
 
     scaleMatrix = glm::scale(mat, glm::vec3(0.50f, 0.50f, 0.50f));
 
-
+    cubes.draw(cubeMesh, lightingShader);
 }
 
 
 
 
 unsigned int loadTexture(const char* path, GLint wrapS, GLint wrapT, GLint minFilter, GLint magFilter) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrChannels;
-    // Load image using stb_image
-    stbi_set_flip_vertically_on_load(true); // Flip the texture vertically if needed
-    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
-    if (data) {
-        GLenum format;
-        if (nrChannels == 1)
-            format = GL_RED;
-        else if (nrChannels == 3)
-            format = GL_RGB;
-        else if (nrChannels == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        // Set texture wrapping parameters
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapS);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapT);
-
-        // Set texture filtering parameters
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
-
-        glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
-    }
-    else {
-        std::cerr << "Failed to load texture at path: " << path << std::endl;
-    }
-
-    stbi_image_free(data); 
-    return textureID;
+    // each image is uploaded once and shared by every sampler state it is requested with;
+    // the returned id names that pairing and is bound through TextureCache::bind()
+    return TextureCache::instance().acquireView(path, wrapS, wrapT, minFilter, magFilter);
 }
 
 
@@ -2465,13 +2626,11 @@ void onMouseClick(double mouseX, double mouseY, int screenWidth, int screenHeigh
     std::cout << "No object was clicked." << std::endl;
 }
 
-void renderLevel2(Shader& shader, GLFWwindow* window, glm::mat4 view, glm::mat4 projection) {
+void renderLevel2(Shader& shader, GLFWwindow* window) {
     shader.use();
-    shader.setMat4("projection", projection);
-    shader.setMat4("view", view);
 
     if (gameOver2) {
-        renderLevel1(shader, window, view, projection); // Transition to moving targets
+        renderLevel1(shader, window); // Transition to moving targets
     }
     else {
         for (Target& target : targets) {
@@ -2482,11 +2641,7 @@ void renderLevel2(Shader& shader, GLFWwindow* window, glm::mat4 view, glm::mat4
         isTargetHit(arrow); // Check for collisions
 
         // Render targets
-        for (Target& target : targets) {
-            if (!target.isHit) {
-                target.draw(shader);
-            }
-        }
+        drawTargets(shader);
 
         // Render arrow
         arrow.draw(shader);
@@ -2504,10 +2659,8 @@ void renderLevel2(Shader& shader, GLFWwindow* window, glm::mat4 view, glm::mat4
 }
 
 
-void renderLevel1(Shader& shader, GLFWwindow* window, glm::mat4 view, glm::mat4 projection) {
+void renderLevel1(Shader& shader, GLFWwindow* window) {
     shader.use();
-    shader.setMat4("projection", projection);
-    shader.setMat4("view", view);
 
 
 
@@ -2524,13 +2677,11 @@ void renderLevel1(Shader& shader, GLFWwindow* window, glm::mat4 view, glm::mat4
             glm::mat4 modelBase = glm::mat4(1.0f);
             modelBase = glm::translate(modelBase, glm::vec3(0.0f, -2.5f, -10.0f));
             modelBase = glm::scale(modelBase, glm::vec3(2.0f * pulsateFactor, 1.5f, 2.0f));
-            shader.setMat4("model", modelBase);
 
             unsigned int baseTexture = loadTexture("gold.jpg", GL_REPEAT, GL_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);
-            SphereWithTexture base(1.0f, 36, 18,
-                glm::vec3(0.3f, 0.3f, 0.3f), glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(1.0f), 32.0f,
-                baseTexture, baseTexture);
-            base.drawSphere(shader, modelBase, camera.Position);
+            static const MaterialId baseMaterial = MaterialTable::instance().add(
+                glm::vec3(0.3f, 0.3f, 0.3f), glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(1.0f), 32.0f);
+            levelMeshes.trophyBase->drawSphere(shader, modelBase, baseMaterial, baseTexture, baseTexture);
 
 
             //body.drawCube(shader, modelBody);
@@ -2569,19 +2720,19 @@ void renderLevel1(Shader& shader, GLFWwindow* window, glm::mat4 view, glm::mat4
             string otherFacesTexturePath2 = "shoot2.jpg";  // Other faces texture (e.g., plain wood)
             unsigned int frontTexture2 = loadTexture(frontTexturePath2.c_str(), GL_REPEAT, GL_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);
             unsigned int otherTexture2 = loadTexture(otherFacesTexturePath2.c_str(), GL_REPEAT, GL_REPEAT, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR);
-            Chest failed = Chest(glm::vec3(1.0f, 1.0f, 1.0f),    // Ambient color
+            static const MaterialId failedMaterial = MaterialTable::instance().add(
+                glm::vec3(1.0f, 1.0f, 1.0f),    // Ambient color
                 glm::vec3(1.0f, 1.0f, 1.0f),    // Diffuse color
-                glm::vec3(0.5f, 0.5f, 0.5f), frontTexture2, otherTexture2, 32.0f);
+                glm::vec3(0.5f, 0.5f, 0.5f), 32.0f);
 
             // Apply transformations: translation, scaling, and rotation
             model = glm::translate(model, glm::vec3(0.0f, -2.0f, -10.0f));  // Position the sphere
             model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
             model = glm::rotate(model, glm::radians(rotationAngle), glm::vec3(0.0f, 1.0f, 0.0f)); // Rotate around Y-axis
             model = glm::scale(model, glm::vec3(3.0f * pulsateFactor)); // Apply pulsation effect
-            shader.setMat4("model", model);
 
 
-            failed.drawCubeWithTwoTextures(shader, model);
+            levelMeshes.lostChest->drawCubeWithTwoTextures(shader, model, failedMaterial, frontTexture2, otherTexture2);
 
    
 
@@ -2601,11 +2752,7 @@ void renderLevel1(Shader& shader, GLFWwindow* window, glm::mat4 view, glm::mat4
 
 
         // Render targets
-        for (Target& target : targets) {
-            if (!target.isHit) {
-                target.draw(shader);
-            }
-        }
+        drawTargets(shader);
         arrow.draw(shader);
 
         // Render trajectory if the arrow is not flying
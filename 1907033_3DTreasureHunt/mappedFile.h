@@ -0,0 +1,135 @@
+//
+//  mappedFile.h
+//
+
+//
+
+#ifndef mappedFile_h
+#define mappedFile_h
+
+#include <string>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+// windef.h still defines these, which clashes with ordinary variable names in main.cpp
+#undef near
+#undef far
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// read-only memory mapping of a whole file; the view stays valid for the object's lifetime
+class MappedFile
+{
+public:
+    MappedFile() {}
+
+    explicit MappedFile(const std::string& path)
+    {
+        open(path);
+    }
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path)
+    {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL)
+        {
+            close();
+            return false;
+        }
+        view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == NULL)
+        {
+            close();
+            return false;
+        }
+        length = (size_t)fileSize.QuadPart;
+#else
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            close();
+            return false;
+        }
+        void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            close();
+            return false;
+        }
+        view = p;
+        length = (size_t)st.st_size;
+#endif
+        return true;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (view)
+            UnmapViewOfFile(view);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (view)
+            munmap(view, length);
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+#endif
+        view = nullptr;
+        length = 0;
+    }
+
+    bool isOpen() const { return view != nullptr; }
+    const unsigned char* data() const { return static_cast<const unsigned char*>(view); }
+    size_t size() const { return length; }
+
+private:
+    void* view = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+};
+
+#endif /* mappedFile_h */
@@ -0,0 +1,172 @@
+//
+//  materialTable.h
+//
+
+//
+
+#ifndef materialTable_h
+#define materialTable_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+#include "shader.h"
+#include "glHandle.h"
+
+// index of a material in the table; draws carry it in their DrawData (drawUniforms.h)
+typedef int MaterialId;
+
+// One material as the shaders' MaterialTable block lays it out (std140: four vec4s). The
+// untextured shaders read ambient, diffuse, specular and emissive; the textured ones take
+// diffuse and specular as the surface colours their maps are blended with.
+struct MaterialData
+{
+    glm::vec4 ambient;      // rgb; w = shininess
+    glm::vec4 diffuse;      // rgb
+    glm::vec4 specular;     // rgb
+    glm::vec4 emissive;     // rgb
+};
+
+static_assert(sizeof(MaterialData) == 64, "MaterialData must match the std140 block");
+
+// Every material of the scene in one uniform buffer, declared the same way in every lighting
+// shader:
+//
+//     layout (std140) uniform MaterialTable
+//     {
+//         MaterialData materials[MAX_MATERIALS];
+//     };
+//
+// A material is registered once and never changes; registering the same values again returns
+// the same id, so draws that share a material share its entry and send no material uniforms.
+// The texture units of the maps are fixed (diffuseMap 0, specularMap 1) and set by attach().
+// GL thread only.
+class MaterialTable
+{
+public:
+    static const GLuint BINDING = 2;            // FrameUniforms uses 0, DrawUniforms 1
+    static const int MAX_MATERIALS = 256;       // 16 KB, the smallest uniform block GL guarantees
+    static const MaterialId DEFAULT = 0;        // white; also returned when the table is full
+
+    static MaterialTable& instance()
+    {
+        static MaterialTable table;
+        return table;
+    }
+
+    // creates the buffer with the materials registered so far; once, after the glad loader
+    void init()
+    {
+        buffer = GLBuffer::create(GL_HERE);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, MAX_MATERIALS * sizeof(MaterialData), nullptr, GL_STATIC_DRAW);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, materials.size() * sizeof(MaterialData), materials.data());
+        buffer.setBytes(MAX_MATERIALS * sizeof(MaterialData));
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, buffer);
+        ++uploads;
+    }
+
+    // points the shader's MaterialTable block, if it has one, at BINDING and its maps at
+    // texture units 0 and 1
+    static void attach(Shader& shader)
+    {
+        GLuint index = glGetUniformBlockIndex(shader.ID, "MaterialTable");
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(shader.ID, index, BINDING);
+        shader.use();
+        shader.setInt("diffuseMap", 0);
+        shader.setInt("specularMap", 1);
+    }
+
+    // Id of the material with these values, registered (and uploaded) the first time
+    MaterialId add(const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular,
+        float shininess, const glm::vec3& emissive = glm::vec3(0.0f))
+    {
+        MaterialData data;
+        data.ambient = glm::vec4(ambient, shininess);
+        data.diffuse = glm::vec4(diffuse, 0.0f);
+        data.specular = glm::vec4(specular, 0.0f);
+        data.emissive = glm::vec4(emissive, 0.0f);
+        return add(data);
+    }
+
+    MaterialId add(const MaterialData& data)
+    {
+        ++lookups;
+        uint64_t hash = hashMaterial(data);
+        auto range = ids.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (memcmp(&materials[it->second], &data, sizeof(MaterialData)) == 0)
+                return it->second;
+        }
+        if ((int)materials.size() == MAX_MATERIALS)
+        {
+            if (!reportedFull)
+                std::cout << "Material table: all " << MAX_MATERIALS << " entries used, further materials draw with the default" << std::endl;
+            reportedFull = true;
+            return DEFAULT;
+        }
+
+        MaterialId id = (MaterialId)materials.size();
+        materials.push_back(data);
+        ids.emplace(hash, id);
+        if (buffer)
+        {
+            // entries in use are never written, so draws already queued are not disturbed
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+            glBufferSubData(GL_UNIFORM_BUFFER, id * sizeof(MaterialData), sizeof(MaterialData), &data);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            ++uploads;
+        }
+        return id;
+    }
+
+    const MaterialData& get(MaterialId id) const
+    {
+        return materials[id];
+    }
+
+    void printStats() const
+    {
+        std::cout << "Material table: " << materials.size() << " of " << MAX_MATERIALS << " materials, "
+            << lookups << " registrations, " << uploads << " uploads" << std::endl;
+    }
+
+    // must run while the GL context is still current
+    void release()
+    {
+        buffer.reset();
+    }
+
+private:
+    GLBuffer buffer;
+    std::vector<MaterialData> materials;
+    std::unordered_multimap<uint64_t, MaterialId> ids;     // hash of the values to their id
+    unsigned long long lookups = 0, uploads = 0;
+    bool reportedFull = false;
+
+    static uint64_t hashMaterial(const MaterialData& data)
+    {
+        uint64_t hash = 1469598103934665603ull;     // FNV-1a
+        const unsigned char* bytes = (const unsigned char*)&data;
+        for (size_t i = 0; i < sizeof(MaterialData); ++i)
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        return hash;
+    }
+
+    MaterialTable()
+    {
+        add(glm::vec3(1.0f), glm::vec3(1.0f), glm::vec3(0.5f), 32.0f);     // DEFAULT
+        lookups = 0;
+    }
+    MaterialTable(const MaterialTable&) = delete;
+    MaterialTable& operator=(const MaterialTable&) = delete;
+};
+
+#endif /* materialTable_h */
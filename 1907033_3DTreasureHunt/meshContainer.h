@@ -0,0 +1,321 @@
+//
+//  meshContainer.h
+//
+
+//
+
+#ifndef meshContainer_h
+#define meshContainer_h
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <iostream>
+#include "mappedFile.h"
+#include "revolution.h"
+
+// Baked mesh container (.thmesh). Layout, all little endian:
+//   MeshContainerHeader
+//   vertex block: vertexCount * floatsPerVertex floats, interleaved x, y, z, nx, ny, nz, u, v
+//   index block: indexCount 32-bit triangle indices
+// Both blocks are 4-byte aligned, offsets counted from the start of the file, so a mapping
+// of the file can be handed to the GPU as it is.
+
+const uint32_t MESH_CONTAINER_MAGIC = 0x534D4854; // "THMS"
+const uint32_t MESH_CONTAINER_VERSION = 1;
+
+struct MeshContainerHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t floatsPerVertex;
+    uint32_t reserved;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+};
+
+// the container that shadows a text mesh; "verticesVase.txt" is baked to "verticesVase.txt.thmesh"
+inline std::string meshContainerPath(const std::string& vertexPath)
+{
+    return vertexPath + ".thmesh";
+}
+
+// validated read-only view of a mapped container
+class MeshContainer
+{
+public:
+    bool open(const std::string& path)
+    {
+        if (!file.open(path))
+            return false;
+        if (!validate())
+        {
+            std::cerr << "Ignoring invalid mesh container: " << path << std::endl;
+            file.close();
+            return false;
+        }
+        return true;
+    }
+
+    bool isOpen() const { return file.isOpen(); }
+
+    const MeshContainerHeader& header() const
+    {
+        return *reinterpret_cast<const MeshContainerHeader*>(file.data());
+    }
+
+    const float* vertices() const
+    {
+        return reinterpret_cast<const float*>(file.data() + header().vertexOffset);
+    }
+
+    const unsigned int* indices() const
+    {
+        return reinterpret_cast<const unsigned int*>(file.data() + header().indexOffset);
+    }
+
+    size_t vertexCount() const { return (size_t)header().vertexCount; }
+    size_t indexCount() const { return (size_t)header().indexCount; }
+    int floatsPerVertex() const { return (int)header().floatsPerVertex; }
+
+private:
+    MappedFile file;
+
+    // also checks every index, so a damaged file cannot make the GPU read past the mesh
+    bool validate() const
+    {
+        if (file.size() < sizeof(MeshContainerHeader))
+            return false;
+        const MeshContainerHeader& h = header();
+        if (h.magic != MESH_CONTAINER_MAGIC || h.version != MESH_CONTAINER_VERSION)
+            return false;
+        if (h.floatsPerVertex < 3 || h.floatsPerVertex > 16 || h.indexCount % 3 != 0)
+            return false;
+        if (h.vertexOffset % 4 != 0 || h.indexOffset % 4 != 0)
+            return false;
+        if (h.vertexOffset + h.vertexCount * h.floatsPerVertex * sizeof(float) > file.size())
+            return false;
+        if (h.indexOffset + h.indexCount * sizeof(unsigned int) > file.size())
+            return false;
+        const unsigned int* index = indices();
+        for (uint64_t i = 0; i < h.indexCount; ++i)
+            if (index[i] >= h.vertexCount)
+                return false;
+        return true;
+    }
+};
+
+// Reads whitespace separated numbers from a text file in one pass over a mapping of the whole
+// file with std::from_chars, into storage reserved from the line count. Only complete records
+// of perRecord values are kept, and parsing stops at the first token that is not a number,
+// like the ifstream >> loops this replaces.
+template <typename T>
+bool parseNumberFile(const std::string& path, size_t perRecord, std::vector<T>& out)
+{
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+
+    const char* p = reinterpret_cast<const char*>(file.data());
+    const char* end = p + file.size();
+    size_t lines = 1;
+    for (const char* q = p; (q = static_cast<const char*>(memchr(q, '\n', end - q))) != nullptr; ++q)
+        ++lines;
+    out.clear();
+    out.reserve(lines * perRecord);
+
+    while (true)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+            ++p;
+        if (p == end)
+            break;
+        if (*p == '+')      // from_chars takes no plus sign; operator>> did
+            ++p;
+        T value;
+        std::from_chars_result result = std::from_chars(p, end, value);
+        if (result.ec != std::errc())
+            break;
+        out.push_back(value);
+        p = result.ptr;
+    }
+    out.resize(out.size() - out.size() % perRecord);
+    return true;
+}
+
+// writes interleaved vertices and triangle indices as a container
+inline bool writeMeshContainer(const std::string& containerPath, const float* vertices, size_t vertexCount,
+    int floatsPerVertex, const unsigned int* indices, size_t indexCount)
+{
+    FILE* out = fopen(containerPath.c_str(), "wb");
+    if (!out)
+    {
+        std::cerr << "Unable to write mesh container: " << containerPath << std::endl;
+        return false;
+    }
+
+    MeshContainerHeader header = { MESH_CONTAINER_MAGIC, MESH_CONTAINER_VERSION, (uint32_t)floatsPerVertex, 0,
+        vertexCount, indexCount, 0, 0 };
+    header.vertexOffset = sizeof(header);
+    header.indexOffset = header.vertexOffset + vertexCount * floatsPerVertex * sizeof(float);
+
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(vertices, sizeof(float) * floatsPerVertex, vertexCount, out);
+    fwrite(indices, sizeof(unsigned int), indexCount, out);
+    bool ok = ferror(out) == 0;
+    fclose(out);
+    return ok;
+}
+
+// offline converter from the text format CurveWithTexture reads (8 floats per vertex line,
+// 3 indices per triangle line) to a container
+inline bool bakeMeshContainer(const std::string& vertexPath, const std::string& indexPath, const std::string& containerPath)
+{
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    if (!parseNumberFile(vertexPath, 8, vertices))
+    {
+        std::cerr << "Error: Unable to open vertices file: " << vertexPath << std::endl;
+        return false;
+    }
+    if (!parseNumberFile(indexPath, 3, indices))
+    {
+        std::cerr << "Error: Unable to open indices file: " << indexPath << std::endl;
+        return false;
+    }
+    size_t vertexCount = vertices.size() / 8;
+    for (unsigned int index : indices)
+    {
+        if (index >= vertexCount)
+        {
+            std::cerr << "Index " << index << " out of range in " << indexPath << " (" << vertexCount << " vertices)" << std::endl;
+            return false;
+        }
+    }
+
+    if (!writeMeshContainer(containerPath, vertices.data(), vertexCount, 8, indices.data(), indices.size()))
+        return false;
+    std::cout << "Baked " << vertexPath << " + " << indexPath << " -> " << containerPath << " (" << vertexCount
+        << " vertices, " << indices.size() / 3 << " triangles)" << std::endl;
+    return true;
+}
+
+// Times the three ways of getting a curve into memory on a generated lathe surface of about
+// vertexCount vertices: the old ifstream >> loops, parseNumberFile() and a mapped container
+// (open, validate and touch every cache line, which is what the GPU upload reads). The scratch
+// files are written to the working directory and removed afterwards.
+inline void benchmarkMeshLoading(size_t vertexCount)
+{
+    int rings = 2;
+    while ((size_t)rings * rings < vertexCount)
+        ++rings;
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    buildRevolution<true>(SphereProfile(1.0f, rings - 1, rings), rings - 1, 0.0f, (float)(2 * PI), nullptr, 0, vertices, indices);
+    size_t count = vertices.size() / 8;
+
+    const std::string vertexPath = "bench_vertices.txt", indexPath = "bench_indices.txt";
+    const std::string containerPath = meshContainerPath(vertexPath);
+    {
+        FILE* out = fopen(vertexPath.c_str(), "w");
+        if (!out)
+        {
+            std::cerr << "Unable to write " << vertexPath << std::endl;
+            return;
+        }
+        for (size_t i = 0; i < vertices.size(); i += 8)
+            fprintf(out, "%g %g %g %g %g %g %g %g\n", vertices[i], vertices[i + 1], vertices[i + 2], vertices[i + 3],
+                vertices[i + 4], vertices[i + 5], vertices[i + 6], vertices[i + 7]);
+        fclose(out);
+        out = fopen(indexPath.c_str(), "w");
+        if (!out)
+        {
+            std::cerr << "Unable to write " << indexPath << std::endl;
+            return;
+        }
+        for (size_t i = 0; i < indices.size(); i += 3)
+            fprintf(out, "%u %u %u\n", indices[i], indices[i + 1], indices[i + 2]);
+        fclose(out);
+    }
+    if (!bakeMeshContainer(vertexPath, indexPath, containerPath))
+        return;
+
+    typedef std::chrono::steady_clock Clock;
+    auto milliseconds = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    // 1: ifstream >> with push_back, as CurveWithTexture used to load
+    Clock::time_point start = Clock::now();
+    std::vector<float> streamVertices;
+    std::vector<unsigned int> streamIndices;
+    {
+        std::ifstream file(vertexPath);
+        float x, y, z, nx, ny, nz, u, v;
+        while (file >> x >> y >> z >> nx >> ny >> nz >> u >> v)
+        {
+            float record[8] = { x, y, z, nx, ny, nz, u, v };
+            streamVertices.insert(streamVertices.end(), record, record + 8);
+        }
+        std::ifstream indexFile(indexPath);
+        unsigned int i1, i2, i3;
+        while (indexFile >> i1 >> i2 >> i3)
+        {
+            streamIndices.push_back(i1);
+            streamIndices.push_back(i2);
+            streamIndices.push_back(i3);
+        }
+    }
+    double streamTime = milliseconds(start);
+
+    // 2: bulk from_chars
+    start = Clock::now();
+    std::vector<float> parsedVertices;
+    std::vector<unsigned int> parsedIndices;
+    parseNumberFile(vertexPath, 8, parsedVertices);
+    parseNumberFile(indexPath, 3, parsedIndices);
+    double parseTime = milliseconds(start);
+
+    // 3: mapped container
+    start = Clock::now();
+    double mapTime = 0.0;
+    bool same = false;
+    {
+        MeshContainer container;
+        unsigned int checksum = 0;
+        if (container.open(containerPath))
+        {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(container.vertices());
+            size_t size = (container.vertexCount() * container.floatsPerVertex() + container.indexCount()) * sizeof(float);
+            for (size_t i = 0; i < size; i += 64)
+                checksum += bytes[i];
+        }
+        mapTime = milliseconds(start);
+        volatile unsigned int sink = checksum;
+        (void)sink;
+
+        same = streamVertices == parsedVertices && streamIndices == parsedIndices && container.isOpen()
+            && container.vertexCount() * 8 == parsedVertices.size() && container.indexCount() == parsedIndices.size()
+            && memcmp(container.vertices(), parsedVertices.data(), parsedVertices.size() * sizeof(float)) == 0
+            && memcmp(container.indices(), parsedIndices.data(), parsedIndices.size() * sizeof(unsigned int)) == 0;
+    }
+
+    std::cout << "Mesh loading, " << count << " vertices, " << indices.size() / 3 << " triangles:" << std::endl;
+    std::cout << "  ifstream >>         " << streamTime << " ms" << std::endl;
+    std::cout << "  from_chars          " << parseTime << " ms (" << streamTime / parseTime << "x)" << std::endl;
+    std::cout << "  mapped container    " << mapTime << " ms (" << streamTime / mapTime << "x)" << std::endl;
+    std::cout << "  results " << (same ? "match" : "DIFFER") << std::endl;
+
+    remove(vertexPath.c_str());
+    remove(indexPath.c_str());
+    remove(containerPath.c_str());
+}
+
+#endif /* meshContainer_h */
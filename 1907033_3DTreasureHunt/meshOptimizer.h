@@ -0,0 +1,379 @@
+//
+//  meshOptimizer.h
+//
+
+//
+
+#ifndef meshOptimizer_h
+#define meshOptimizer_h
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+
+// Post-transform cache statistics of a triangle list. ACMR is vertex shader runs per
+// triangle (0.5 is the floor for a regular grid, 3 means no reuse at all), ATVR is runs per
+// distinct vertex (1 is perfect).
+struct VertexCacheStats
+{
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+// Simulates a FIFO post-transform cache of cacheSize entries over the index list
+inline VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, int cacheSize = 32)
+{
+    VertexCacheStats stats;
+    if (indices.empty() || vertexCount == 0)
+        return stats;
+
+    std::vector<unsigned long long> cachedAt(vertexCount, 0);   // time of the miss that loaded it, 0 = never
+    unsigned long long misses = 0;
+    std::vector<bool> used(vertexCount, false);
+    size_t usedCount = 0;
+    for (unsigned int index : indices)
+    {
+        // a vertex is still cached while fewer than cacheSize misses happened since it was loaded
+        if (cachedAt[index] == 0 || misses - cachedAt[index] + 1 > (unsigned long long)cacheSize)
+        {
+            ++misses;
+            cachedAt[index] = misses;
+        }
+        if (!used[index])
+        {
+            used[index] = true;
+            ++usedCount;
+        }
+    }
+    stats.acmr = (float)misses / (indices.size() / 3);
+    stats.atvr = (float)misses / usedCount;
+    return stats;
+}
+
+// Merges vertices whose attributes all agree to within tolerance (snapped to a grid of that
+// size) and rewrites the indices. The first vertex of each group is kept. Returns the new count.
+inline size_t weldVertices(std::vector<float>& vertices, int floatsPerVertex, std::vector<unsigned int>& indices, float tolerance)
+{
+    size_t vertexCount = vertices.size() / floatsPerVertex;
+    std::unordered_map<std::string, unsigned int> firstOfCell;
+    firstOfCell.reserve(vertexCount);
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<float> welded;
+    welded.reserve(vertices.size());
+
+    std::string key(floatsPerVertex * sizeof(int32_t), '\0');
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const float* v = &vertices[i * floatsPerVertex];
+        for (int k = 0; k < floatsPerVertex; ++k)
+        {
+            int32_t cell = (int32_t)lroundf(v[k] / tolerance);
+            memcpy(&key[k * sizeof(int32_t)], &cell, sizeof(cell));
+        }
+        auto found = firstOfCell.emplace(key, (unsigned int)(welded.size() / floatsPerVertex));
+        if (found.second)
+            welded.insert(welded.end(), v, v + floatsPerVertex);
+        remap[i] = found.first->second;
+    }
+
+    for (unsigned int& index : indices)
+        index = remap[index];
+    vertices.swap(welded);
+    return vertices.size() / floatsPerVertex;
+}
+
+// Tom Forsyth's linear-speed vertex cache optimisation: triangles are emitted greedily by the
+// score of their vertices, which favours vertices in a simulated LRU cache and vertices with
+// few triangles left, so the mesh is drawn in small patches that reuse the cache.
+inline void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+    const int CACHE_SIZE = 32;
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // triangles of each vertex, as offsets into one list
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (unsigned int index : indices)
+        ++remaining[index];
+    std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+        firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+    std::vector<unsigned int> vertexTriangles(indices.size());
+    std::vector<unsigned int> filled(vertexCount, 0);
+    for (size_t t = 0; t < triangleCount; ++t)
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int v = indices[t * 3 + k];
+            vertexTriangles[firstTriangle[v] + filled[v]++] = (unsigned int)t;
+        }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    auto vertexScore = [&](unsigned int v) {
+        if (remaining[v] == 0)
+            return -1.0f;
+        float score = 0.0f;
+        int position = cachePosition[v];
+        if (position >= 0)
+        {
+            if (position < 3)
+                score = LAST_TRIANGLE_SCORE;    // the triangle just drawn; a fixed score avoids favouring one of its edges
+            else
+                score = powf(1.0f - (float)(position - 3) / (CACHE_SIZE - 3), CACHE_DECAY_POWER);
+        }
+        return score + VALENCE_BOOST_SCALE * powf((float)remaining[v], -VALENCE_BOOST_POWER);
+    };
+
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        score[v] = vertexScore((unsigned int)v);
+    std::vector<float> triangleScore(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t)
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(CACHE_SIZE + 3);
+    nextCache.reserve(CACHE_SIZE + 3);
+    size_t scanFrom = 0;
+
+    int best = 0;
+    for (size_t t = 1; t < triangleCount; ++t)
+        if (triangleScore[t] > triangleScore[best])
+            best = (int)t;
+
+    while (best >= 0)
+    {
+        emitted[best] = true;
+        const unsigned int* triangle = &indices[best * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+
+        // the triangle's vertices go to the front of the cache, in order
+        nextCache.assign(triangle, triangle + 3);
+        for (unsigned int v : cache)
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                nextCache.push_back(v);
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int v = triangle[k];
+            unsigned int* list = &vertexTriangles[firstTriangle[v]];
+            for (unsigned int i = 0; i < remaining[v]; ++i)
+                if (list[i] == (unsigned int)best)
+                {
+                    list[i] = list[remaining[v] - 1];
+                    break;
+                }
+            --remaining[v];
+        }
+
+        // rescore everything that was or is in the cache, then their triangles
+        for (size_t i = 0; i < nextCache.size(); ++i)
+            cachePosition[nextCache[i]] = i < (size_t)CACHE_SIZE ? (int)i : -1;
+        for (unsigned int v : nextCache)
+            score[v] = vertexScore(v);
+        best = -1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < nextCache.size(); ++i)
+        {
+            unsigned int v = nextCache[i];
+            for (unsigned int j = 0; j < remaining[v]; ++j)
+            {
+                unsigned int t = vertexTriangles[firstTriangle[v] + j];
+                float s = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+                triangleScore[t] = s;
+                if (s > bestScore)
+                {
+                    bestScore = s;
+                    best = (int)t;
+                }
+            }
+        }
+        if (nextCache.size() > (size_t)CACHE_SIZE)
+            nextCache.resize(CACHE_SIZE);
+        cache.swap(nextCache);
+
+        // nothing left around the cache: continue with the next triangle not drawn yet
+        if (best < 0)
+        {
+            while (scanFrom < triangleCount && emitted[scanFrom])
+                ++scanFrom;
+            if (scanFrom < triangleCount)
+                best = (int)scanFrom;
+        }
+    }
+    indices.swap(output);
+}
+
+// Renumbers vertices in the order the indices first use them, so vertex fetch walks the buffer
+// forwards; vertices no index uses are dropped. Returns the new vertex count.
+inline size_t optimizeVertexFetch(std::vector<float>& vertices, int floatsPerVertex, std::vector<unsigned int>& indices)
+{
+    size_t vertexCount = vertices.size() / floatsPerVertex;
+    const unsigned int UNUSED = 0xFFFFFFFFu;
+    std::vector<unsigned int> remap(vertexCount, UNUSED);
+    std::vector<float> ordered;
+    ordered.reserve(vertices.size());
+    for (unsigned int& index : indices)
+    {
+        if (remap[index] == UNUSED)
+        {
+            remap[index] = (unsigned int)(ordered.size() / floatsPerVertex);
+            ordered.insert(ordered.end(), &vertices[index * floatsPerVertex], &vertices[index * floatsPerVertex] + floatsPerVertex);
+        }
+        index = remap[index];
+    }
+    vertices.swap(ordered);
+    return vertices.size() / floatsPerVertex;
+}
+
+// Greedy stripifier. Strips follow the triangle order (so they keep its cache locality) and
+// are separated by restartIndex for GL_PRIMITIVE_RESTART; winding is preserved.
+inline std::vector<unsigned int> buildTriangleStrips(const std::vector<unsigned int>& indices, unsigned int restartIndex)
+{
+    size_t triangleCount = indices.size() / 3;
+    unsigned int vertexCount = 0;
+    for (unsigned int index : indices)
+        if (index + 1 > vertexCount)
+            vertexCount = index + 1;
+
+    // triangles of each vertex, as offsets into one list
+    std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+    for (unsigned int index : indices)
+        ++firstTriangle[index + 1];
+    for (unsigned int v = 0; v < vertexCount; ++v)
+        firstTriangle[v + 1] += firstTriangle[v];
+    std::vector<unsigned int> vertexTriangles(indices.size());
+    std::vector<unsigned int> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+        vertexTriangles[filled[indices[i]]++] = (unsigned int)(i / 3);
+
+    // an unused triangle holding the directed edge a->b, and its third vertex
+    std::vector<bool> used(triangleCount, false);
+    auto findEdge = [&](unsigned int a, unsigned int b, unsigned int& third) {
+        for (unsigned int i = firstTriangle[a]; i < firstTriangle[a + 1]; ++i)
+        {
+            unsigned int t = vertexTriangles[i];
+            if (used[t])
+                continue;
+            for (int k = 0; k < 3; ++k)
+                if (indices[t * 3 + k] == a && indices[t * 3 + (k + 1) % 3] == b)
+                {
+                    third = indices[t * 3 + (k + 2) % 3];
+                    return (int)t;
+                }
+        }
+        return -1;
+    };
+
+    std::vector<unsigned int> strips;
+    strips.reserve(indices.size());
+    for (size_t start = 0; start < triangleCount; ++start)
+    {
+        if (used[start])
+            continue;
+        used[start] = true;
+        if (!strips.empty())
+            strips.push_back(restartIndex);
+        strips.insert(strips.end(), &indices[start * 3], &indices[start * 3] + 3);
+
+        // triangle k of a strip is (s[k], s[k+1], s[k+2]) for even k and (s[k+1], s[k], s[k+2])
+        // for odd k, so the next one must hold the directed edge p->q or q->p accordingly
+        for (size_t k = 1;; ++k)
+        {
+            unsigned int p = strips[strips.size() - 2], q = strips[strips.size() - 1], third = 0;
+            int next = k % 2 == 0 ? findEdge(p, q, third) : findEdge(q, p, third);
+            if (next < 0)
+                break;
+            used[next] = true;
+            strips.push_back(third);
+        }
+    }
+    return strips;
+}
+
+// Runs every mesh through welding, vertex cache ordering and vertex fetch ordering before it is
+// uploaded, and keeps a before/after line per mesh for printReport(). GL thread only.
+class MeshOptimizer
+{
+public:
+    static MeshOptimizer& instance()
+    {
+        static MeshOptimizer optimizer;
+        return optimizer;
+    }
+
+    float weldTolerance = 1e-5f;
+
+    // splits are index positions starting a new range; triangles are only reordered within a range
+    void optimize(std::vector<float>& vertices, int floatsPerVertex, std::vector<unsigned int>& indices, const char* name,
+        const std::vector<size_t>* splits = nullptr)
+    {
+        MeshReport report;
+        report.name = name;
+        report.verticesBefore = vertices.size() / floatsPerVertex;
+        report.before = analyzeVertexCache(indices, report.verticesBefore);
+
+        weldVertices(vertices, floatsPerVertex, indices, weldTolerance);
+        if (splits && !splits->empty())
+        {
+            size_t begin = 0;
+            for (size_t k = 0; k <= splits->size(); ++k)
+            {
+                size_t end = k < splits->size() ? (*splits)[k] : indices.size();
+                std::vector<unsigned int> range(indices.begin() + begin, indices.begin() + end);
+                optimizeVertexCache(range, vertices.size() / floatsPerVertex);
+                std::copy(range.begin(), range.end(), indices.begin() + begin);
+                begin = end;
+            }
+        }
+        else
+            optimizeVertexCache(indices, vertices.size() / floatsPerVertex);
+        report.verticesAfter = optimizeVertexFetch(vertices, floatsPerVertex, indices);
+        report.after = analyzeVertexCache(indices, report.verticesAfter);
+        report.triangles = indices.size() / 3;
+        report.stripIndices = buildTriangleStrips(indices, 0xFFFFFFFFu).size();
+        reports.push_back(report);
+    }
+
+    void printReport() const
+    {
+        std::cout << "Mesh optimizer: " << reports.size() << " meshes (FIFO cache of 32)" << std::endl;
+        for (const MeshReport& r : reports)
+        {
+            std::cout << "  " << r.name << ": " << r.triangles << " triangles, vertices " << r.verticesBefore << " -> " << r.verticesAfter
+                << ", ACMR " << r.before.acmr << " -> " << r.after.acmr << ", ATVR " << r.before.atvr << " -> " << r.after.atvr
+                << ", strips " << r.stripIndices << " indices vs " << r.triangles * 3 << std::endl;
+        }
+    }
+
+private:
+    struct MeshReport
+    {
+        std::string name;
+        size_t verticesBefore = 0;
+        size_t verticesAfter = 0;
+        size_t triangles = 0;
+        size_t stripIndices = 0;
+        VertexCacheStats before;
+        VertexCacheStats after;
+    };
+    std::vector<MeshReport> reports;
+
+    MeshOptimizer() {}
+    MeshOptimizer(const MeshOptimizer&) = delete;
+    MeshOptimizer& operator=(const MeshOptimizer&) = delete;
+};
+
+#endif /* meshOptimizer_h */
@@ -0,0 +1,118 @@
+//
+//  meshRegistry.h
+//
+
+//
+
+#ifndef meshRegistry_h
+#define meshRegistry_h
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <iostream>
+#include "sphereWithTexture.h"
+#include "cylinderWithTexture.h"
+#include "chest.h"
+
+// primitive type plus the parameters its tessellation depends on (never the material)
+struct MeshKey
+{
+    std::string type;
+    std::vector<float> shape;
+
+    bool operator==(const MeshKey& other) const
+    {
+        return type == other.type && shape == other.shape;
+    }
+};
+
+struct MeshKeyHash
+{
+    size_t operator()(const MeshKey& key) const
+    {
+        size_t h = std::hash<std::string>()(key.type);
+        for (float p : key.shape)
+            h ^= std::hash<float>()(p) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+// Builds each primitive once per shape and hands out the shared instance, so nothing is
+// tessellated and no VAO or buffer is created in the render loop. The shared meshes are
+// const: callers pass their own material to every draw, so one user's look never leaks
+// into another's. Look meshes up once (building the key allocates) and keep the
+// reference, which stays valid until clear().
+class MeshRegistry
+{
+public:
+    static MeshRegistry& instance()
+    {
+        static MeshRegistry registry;
+        return registry;
+    }
+
+    const CylinderWithTexture& cylinderWithTexture(float baseRadius, float topRadius, float height, int sectorCount, int stackCount)
+    {
+        MeshKey key = { "CylinderWithTexture", { baseRadius, topRadius, height, (float)sectorCount, (float)stackCount } };
+        return get<CylinderWithTexture>(key, [=] {
+            return new CylinderWithTexture(baseRadius, topRadius, height, sectorCount, stackCount);
+        });
+    }
+
+    const SphereWithTexture& sphereWithTexture(float radius, int sectorCount, int stackCount)
+    {
+        MeshKey key = { "SphereWithTexture", { radius, (float)sectorCount, (float)stackCount } };
+        return get<SphereWithTexture>(key, [=] { return new SphereWithTexture(radius, sectorCount, stackCount); });
+    }
+
+    // the unit cube with a separately textured front face
+    const Chest& chest()
+    {
+        MeshKey key = { "Chest", {} };
+        return get<Chest>(key, [] { return new Chest(); });
+    }
+
+    size_t count() const
+    {
+        return meshes.size();
+    }
+
+    void printStats() const
+    {
+        std::cout << "Mesh registry: " << meshes.size() << " meshes built, " << hits << " lookups served without building" << std::endl;
+    }
+
+    // must run while the GL context is still current
+    void clear()
+    {
+        meshes.clear();
+    }
+
+private:
+    std::unordered_map<MeshKey, std::shared_ptr<void>, MeshKeyHash> meshes;    // deleter keeps the real type
+    unsigned long long hits = 0;
+
+    template <typename Mesh, typename Build>
+    const Mesh& get(const MeshKey& key, Build build)
+    {
+        auto it = meshes.find(key);
+        if (it != meshes.end())
+        {
+            ++hits;
+            return *static_cast<Mesh*>(it->second.get());
+        }
+        std::shared_ptr<Mesh> mesh(build());
+        meshes.emplace(key, mesh);
+        return *mesh;
+    }
+
+    MeshRegistry() {}
+    MeshRegistry(const MeshRegistry&) = delete;
+    MeshRegistry& operator=(const MeshRegistry&) = delete;
+};
+
+#endif /* meshRegistry_h */
@@ -0,0 +1,180 @@
+//
+//  normalMatrixBenchmark.h
+//
+
+//
+
+#ifndef normalMatrixBenchmark_h
+#define normalMatrixBenchmark_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <iostream>
+#include "shader.h"
+#include "glHandle.h"
+#include "revolution.h"
+#include "frameUniforms.h"
+#include "drawUniforms.h"
+#include "materialTable.h"
+#include "geometryArena.h"
+
+// GPU time of the vertex stage of one program: draws of the mesh in vao, one per slot of
+// batch, with rasterization off so only the vertices are paid for. Best of a few runs.
+inline double timeVertexStage(Shader& shader, GLuint vao, GLsizei indexCount, const DrawBatch& batch, size_t draws)
+{
+    GLuint query = 0;
+    glGenQueries(1, &query);
+    shader.use();
+    glBindVertexArray(vao);
+    glEnable(GL_RASTERIZER_DISCARD);
+    double best = 0.0;
+    for (int run = 0; run < 6; ++run)
+    {
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        for (size_t i = 0; i < draws; ++i)
+        {
+            batch.bind(i);
+            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+        }
+        glEndQuery(GL_TIME_ELAPSED);
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+        double milliseconds = nanoseconds / 1.0e6;
+        if (run > 0 && (best == 0.0 || milliseconds < best))     // run 0 warms up
+            best = milliseconds;
+    }
+    glDisable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(0);
+    GeometryArena::instance().invalidateBinding();
+    glDeleteQueries(1, &query);
+    return best;
+}
+
+// Compares the lit textured vertex shader reading draw.normalMatrix with the same shader
+// working out mat3(transpose(inverse(model))) per vertex, as it used to, by GL_TIME_ELAPSED
+// queries over draws of a generated sphere of about vertexCount vertices. Also times the
+// CPU side: normal matrices for rigid/uniform-scale models (the fast path) and squashed ones.
+// Needs the context current and FrameUniforms, DrawUniforms and MaterialTable initialised.
+// The per-vertex variant is written to the working directory and removed afterwards.
+inline void benchmarkNormalMatrix(size_t vertexCount, size_t draws)
+{
+    const char* vertexPath = "vertexShaderForPhongShadingWithTexture.vs";
+    const char* fragmentPath = "fragmentShaderForPhongShadingWithTexture.fs";
+    const std::string inversePath = "bench_inverse_normal.vs";
+    {
+        std::ifstream file(vertexPath);
+        std::stringstream source;
+        source << file.rdbuf();
+        std::string code = source.str();
+        const std::string precomputed = "draw.normalMatrix";
+        size_t at = code.find(precomputed);
+        if (at == std::string::npos)
+        {
+            std::cerr << vertexPath << " does not read draw.normalMatrix" << std::endl;
+            return;
+        }
+        code.replace(at, precomputed.size(), "mat3(transpose(inverse(draw.model)))");
+        std::ofstream out(inversePath);
+        out << code;
+    }
+    Shader precomputedShader(vertexPath, fragmentPath);
+    Shader inverseShader(inversePath.c_str(), fragmentPath);
+    remove(inversePath.c_str());
+    for (Shader* shader : { &precomputedShader, &inverseShader })
+    {
+        FrameUniforms::attach(*shader);
+        DrawUniforms::attach(*shader);
+        MaterialTable::attach(*shader);
+    }
+
+    int rings = 2;
+    while ((size_t)rings * rings < vertexCount)
+        ++rings;
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    buildRevolution<true>(SphereProfile(1.0f, rings - 1, rings), rings - 1, 0.0f, (float)(2 * PI), nullptr, 0, vertices, indices);
+
+    GLVertexArray vao = GLVertexArray::create(GL_HERE);
+    GLBuffer vbo = GLBuffer::create(GL_HERE);
+    GLBuffer ebo = GLBuffer::create(GL_HERE);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    vbo.setBytes(vertices.size() * sizeof(float));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    ebo.setBytes(indices.size() * sizeof(unsigned int));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glBindVertexArray(0);
+    GeometryArena::instance().invalidateBinding();
+
+    FrameUniforms& frame = FrameUniforms::instance();
+    frame.setCamera(glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f),
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(0.0f, 0.0f, 10.0f));
+    frame.upload();
+
+    // spinning, uniformly scaled objects, with every fourth squashed like the furniture boxes
+    std::vector<glm::mat4> models;
+    for (size_t i = 0; i < draws; ++i)
+    {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3((float)(i % 10) - 5.0f, (float)(i / 10 % 10) - 5.0f, 0.0f));
+        model = glm::rotate(model, (float)i * 0.37f, glm::normalize(glm::vec3(1.0f, (float)(i % 3), 0.5f)));
+        model = glm::scale(model, i % 4 == 3 ? glm::vec3(0.2f, 0.8f, 0.3f) : glm::vec3(0.3f));
+        models.push_back(model);
+    }
+
+    DrawUniforms& uniforms = DrawUniforms::instance();
+    uniforms.beginFrame();
+    DrawBatch batch;
+    for (const glm::mat4& model : models)
+        batch.add(model);
+    batch.write();
+    GLsizei indexCount = (GLsizei)indices.size();
+    double inverseTime = timeVertexStage(inverseShader, vao, indexCount, batch, draws);
+    double precomputedTime = timeVertexStage(precomputedShader, vao, indexCount, batch, draws);
+    uniforms.endFrame();
+
+    typedef std::chrono::steady_clock Clock;
+    const int repeats = 1000;
+    glm::mat4 rigid = glm::scale(glm::rotate(glm::mat4(1.0f), 0.7f, glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(2.0f));
+    glm::mat4 squashed = glm::scale(rigid, glm::vec3(1.0f, 0.1f, 1.0f));
+    float sink = 0.0f;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < repeats; ++i)
+    {
+        rigid[3][0] = (float)i;
+        sink += normalMatrixOf(rigid)[0][0];
+    }
+    double fastTime = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    start = Clock::now();
+    for (int i = 0; i < repeats; ++i)
+    {
+        squashed[3][0] = (float)i;
+        sink += normalMatrixOf(squashed)[0][0];
+    }
+    double invertedTime = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    volatile float result = sink;
+    (void)result;
+
+    size_t sphereVertices = vertices.size() / 8;
+    std::cout << "Normal matrix, " << draws << " draws of a " << sphereVertices << "-vertex sphere, vertex stage GPU time:" << std::endl;
+    std::cout << "  inverse per vertex      " << inverseTime << " ms" << std::endl;
+    std::cout << "  precomputed per draw    " << precomputedTime << " ms (" << inverseTime / precomputedTime << "x)" << std::endl;
+    std::cout << "  CPU per draw            " << fastTime / repeats << " us rigid or uniform scale, "
+        << invertedTime / repeats << " us with inverse" << std::endl;
+}
+
+#endif /* normalMatrixBenchmark_h */
@@ -9,7 +9,8 @@
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
-#include "shader.h"
+#include <cmath>
+#include "frameUniforms.h"
 
 class PointLight {
 public:
@@ -38,76 +39,21 @@ public:
         isFlickering = flickering;
         flickerIntensity = intensity;
     }
-    void setUpPointLight(Shader& lightingShader, float time)
+    // This light's entry in the frame uniform block (frameUniforms.h), shared by every lighting
+    // program; a light that is off goes dark and is flagged off in position.w
+    void setUpFrameLight(FramePointLight& light, bool isEnabled, float time) const
     {
         int l = lightNumber - 1;
-        std::string index = std::to_string(l);
-        lightingShader.use();
-
-        // Calculate flicker effect if enabled
-        float flickerFactor = 1.0f; // Default no flicker
-        if (isFlickering) {
-            flickerFactor = 1.0f - flickerIntensity * (0.5f + 0.5f * sin(time * 20.0f + l + sin(time * 5.0f) * 2.0f));
-        }
-
-
-        // Apply flicker factor to light components
-        glm::vec3 flickerAmbient = ambientOn * ambient * flickerFactor;
-        glm::vec3 flickerDiffuse = diffuseOn * diffuse * flickerFactor;
-        glm::vec3 flickerSpecular = specularOn * specular * flickerFactor;
-
-        if (lightNumber == 1) {
-            lightingShader.setVec3("pointLights[0].position", position);
-            lightingShader.setVec3("pointLights[0].ambient", ambientOn * flickerAmbient);
-            lightingShader.setVec3("pointLights[0].diffuse", diffuseOn * flickerDiffuse);
-            lightingShader.setVec3("pointLights[0].specular", specularOn * flickerSpecular);
-            lightingShader.setFloat("pointLights[0].k_c", k_c);
-            lightingShader.setFloat("pointLights[0].k_l", k_l);
-            lightingShader.setFloat("pointLights[0].k_q", k_q);
-        }
-
-        else if (lightNumber == 2)
-        {
-            lightingShader.setVec3("pointLights[1].position", position);
-            lightingShader.setVec3("pointLights[1].ambient", ambientOn * flickerSpecular);
-            lightingShader.setVec3("pointLights[1].diffuse", diffuseOn * flickerSpecular);
-            lightingShader.setVec3("pointLights[1].specular", specularOn * flickerSpecular);
-            lightingShader.setFloat("pointLights[1].k_c", k_c);
-            lightingShader.setFloat("pointLights[1].k_l", k_l);
-            lightingShader.setFloat("pointLights[1].k_q", k_q);
-        }
-
-    }
-    void setUpPointLight2(Shader& lightingShader, bool isEnabled, float time) {
-        int l = lightNumber - 1;
-        std::string index = std::to_string(l);
-        lightingShader.use();
         float flickerFactor = 1.0f; // Default no flicker
         if (isFlickering) {
             flickerFactor = 1.0f - flickerIntensity * (0.5f + 0.5f * sin(time * 10.0f + l));
         }
+        float on = isEnabled ? 1.0f : 0.0f;
         // Apply flicker factor to light components
-        glm::vec3 flickerAmbient = ambientOn * ambient * flickerFactor;
-        glm::vec3 flickerDiffuse = diffuseOn * diffuse * flickerFactor;
-        glm::vec3 flickerSpecular = specularOn * specular * flickerFactor;
-        std::string prefix = "pointLights[" + std::to_string(lightNumber - 1) + "]";
-
-        lightingShader.setVec3(prefix + ".position", position);
-
-        if (isEnabled) {
-            lightingShader.setVec3(prefix + ".ambient", flickerAmbient);
-            lightingShader.setVec3(prefix + ".diffuse", flickerDiffuse);
-            lightingShader.setVec3(prefix + ".specular", flickerSpecular);
-        }
-        else {
-            lightingShader.setVec3(prefix + ".ambient", glm::vec3(0.0f));
-            lightingShader.setVec3(prefix + ".diffuse", glm::vec3(0.0f));
-            lightingShader.setVec3(prefix + ".specular", glm::vec3(0.0f));
-        }
-
-        lightingShader.setFloat(prefix + ".k_c", k_c);
-        lightingShader.setFloat(prefix + ".k_l", k_l);
-        lightingShader.setFloat(prefix + ".k_q", k_q);
+        light.position = glm::vec4(position, on);
+        light.ambient = glm::vec4(on * ambientOn * ambient * flickerFactor, k_c);
+        light.diffuse = glm::vec4(on * diffuseOn * diffuse * flickerFactor, k_l);
+        light.specular = glm::vec4(on * specularOn * specular * flickerFactor, k_q);
     }
 
 
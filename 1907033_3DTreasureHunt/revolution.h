@@ -0,0 +1,274 @@
+//
+//  revolution.h
+//
+
+//
+
+#ifndef revolution_h
+#define revolution_h
+
+#include <vector>
+#include <map>
+#include <tuple>
+#include <cmath>
+
+#define PI 3.14159265359
+
+// One ring of a surface of revolution: its radius and height, the (radial, vertical) normal
+// direction shared by every vertex on it and the v texture coordinate. pole marks a ring the
+// profile collapses to a point (a sphere's poles, a cone's apex); it is set by the profile
+// from the ring index, never guessed from how small the radius came out.
+struct RevolutionRing
+{
+    float radius;
+    float y;
+    float normalRadial;
+    float normalY;
+    float v;
+    bool pole;
+};
+
+// flat disk closing a surface at height y; top caps face +y, bottom caps -y
+struct RevolutionCap
+{
+    float radius;
+    float y;
+    bool top;
+};
+
+// Profiles describe the surface from top to bottom (or bottom to top) as a list of rings.
+// They are template arguments of buildRevolution(), so their ring() calls are inlined.
+
+// sphere of the given radius, rings from the north pole (+y) down; ringCount() below
+// stackCount + 1 keeps only the upper part (stackCount / 2 + 1 rings is the hemisphere)
+struct SphereProfile
+{
+    float radius;
+    int stackCount;
+    int rings;
+
+    SphereProfile(float radius, int stackCount, int rings) : radius(radius), stackCount(stackCount), rings(rings) {}
+
+    int ringCount() const
+    {
+        return rings;
+    }
+
+    RevolutionRing ring(int i) const
+    {
+        float stackAngle = (float)(PI / 2 - i * PI / stackCount);
+        float c = cosf(stackAngle), s = sinf(stackAngle);
+        RevolutionRing r = { radius * c, radius * s, c, s, (float)i / stackCount, i == 0 || i == stackCount };
+        return r;
+    }
+};
+
+// cylinder or truncated cone centred on the origin, rings from -height/2 up; the side normal
+// stays horizontal like the original cylinders, whatever the taper
+struct FrustumProfile
+{
+    float baseRadius;
+    float topRadius;
+    float height;
+    int stackCount;
+
+    FrustumProfile(float baseRadius, float topRadius, float height, int stackCount)
+        : baseRadius(baseRadius), topRadius(topRadius), height(height), stackCount(stackCount) {}
+
+    int ringCount() const
+    {
+        return stackCount + 1;
+    }
+
+    RevolutionRing ring(int i) const
+    {
+        float t = (float)i / stackCount;
+        bool pole = (i == 0 && baseRadius == 0.0f) || (i == stackCount && topRadius == 0.0f);
+        RevolutionRing r = { baseRadius + (topRadius - baseRadius) * t, -height / 2 + i * height / stackCount, 1.0f, 0.0f, t, pole };
+        return r;
+    }
+};
+
+// cone standing on y = 0 with its apex at y = height; the side normal follows the slant
+struct ConeProfile
+{
+    float radius;
+    float height;
+
+    ConeProfile(float radius, float height) : radius(radius), height(height) {}
+
+    int ringCount() const
+    {
+        return 2;
+    }
+
+    RevolutionRing ring(int i) const
+    {
+        float length = sqrtf(radius * radius + height * height);
+        RevolutionRing r = { i == 0 ? radius : 0.0f, i == 0 ? 0.0f : height, height / length, radius / length, (float)i, i == 1 };
+        return r;
+    }
+};
+
+// cosines and sines of sectorCount + 1 evenly spaced angles from startAngle over sweep
+struct SectorTable
+{
+    std::vector<float> cosines;
+    std::vector<float> sines;
+};
+
+// The table for a sector layout is computed once and shared by every mesh built with it,
+// so the trig cost of a mesh no longer grows with its stack count. GL thread only.
+inline const SectorTable& sectorTable(int sectorCount, float startAngle, float sweep)
+{
+    static std::map<std::tuple<int, float, float>, SectorTable> tables;
+    std::tuple<int, float, float> key(sectorCount, startAngle, sweep);
+    auto it = tables.find(key);
+    if (it != tables.end())
+        return it->second;
+
+    SectorTable& table = tables[key];
+    table.cosines.resize(sectorCount + 1);
+    table.sines.resize(sectorCount + 1);
+    for (int j = 0; j <= sectorCount; ++j)
+    {
+        float angle = startAngle + sweep * j / sectorCount;
+        table.cosines[j] = cosf(angle);
+        table.sines[j] = sinf(angle);
+    }
+    return table;
+}
+
+// Builds a surface of revolution around the y axis plus optional caps straight into
+// interleaved vertices (position, normal and, with TexCoords, uv) and triangle indices.
+// Both buffers are sized up front and written in place. A vertex at angle a sits at
+// (radius cos a, y, radius sin a). Quads touching a pole ring lose their degenerate triangle.
+// FixedSectors > 0 turns the sector count into a compile-time constant, so the per-ring
+// loops have a known trip count; sectorCount is ignored then. buildRevolutionSpecialized()
+// picks it for the tessellations the game uses.
+template <bool TexCoords, int FixedSectors = 0, typename Profile>
+void buildRevolution(const Profile& profile, int sectorCount, float startAngle, float sweep,
+    const RevolutionCap* caps, int capCount, std::vector<float>& vertices, std::vector<unsigned int>& indices)
+{
+    const int sectors = FixedSectors > 0 ? FixedSectors : sectorCount;
+    const int floatsPerVertex = TexCoords ? 8 : 6;
+    const SectorTable& table = sectorTable(sectors, startAngle, sweep);
+    const float* cosines = table.cosines.data();
+    const float* sines = table.sines.data();
+
+    int ringCount = profile.ringCount();
+    std::vector<RevolutionRing> rings(ringCount);
+    std::vector<bool> pole(ringCount);
+    for (int i = 0; i < ringCount; ++i)
+    {
+        rings[i] = profile.ring(i);
+        pole[i] = rings[i].pole;
+    }
+
+    size_t triangles = (size_t)capCount * sectors;
+    for (int i = 0; i + 1 < ringCount; ++i)
+        triangles += (size_t)sectors * ((pole[i] ? 0 : 1) + (pole[i + 1] ? 0 : 1));
+    size_t vertexCount = (size_t)ringCount * (sectors + 1) + (size_t)capCount * (sectors + 2);
+    vertices.resize(vertexCount * floatsPerVertex);
+    indices.resize(triangles * 3);
+
+    float* v = vertices.data();
+    for (int i = 0; i < ringCount; ++i)
+    {
+        const RevolutionRing& ring = rings[i];
+        for (int j = 0; j <= sectors; ++j)
+        {
+            *v++ = ring.radius * cosines[j];
+            *v++ = ring.y;
+            *v++ = ring.radius * sines[j];
+            *v++ = ring.normalRadial * cosines[j];
+            *v++ = ring.normalY;
+            *v++ = ring.normalRadial * sines[j];
+            if (TexCoords)
+            {
+                *v++ = (float)j / sectors;
+                *v++ = ring.v;
+            }
+        }
+    }
+
+    // k1--k1+1
+    // |  / |
+    // | /  |
+    // k2--k2+1
+    unsigned int* index = indices.data();
+    for (int i = 0; i + 1 < ringCount; ++i)
+    {
+        unsigned int k1 = i * (sectors + 1);
+        unsigned int k2 = k1 + sectors + 1;
+        for (int j = 0; j < sectors; ++j, ++k1, ++k2)
+        {
+            if (!pole[i])
+            {
+                *index++ = k1;
+                *index++ = k2;
+                *index++ = k1 + 1;
+            }
+            if (!pole[i + 1])
+            {
+                *index++ = k1 + 1;
+                *index++ = k2;
+                *index++ = k2 + 1;
+            }
+        }
+    }
+
+    unsigned int base = ringCount * (sectors + 1);
+    for (int c = 0; c < capCount; ++c)
+    {
+        const RevolutionCap& cap = caps[c];
+        float normalY = cap.top ? 1.0f : -1.0f;
+        for (int j = -1; j <= sectors; ++j)
+        {
+            // j == -1 is the centre
+            float x = j < 0 ? 0.0f : cap.radius * cosines[j];
+            float z = j < 0 ? 0.0f : cap.radius * sines[j];
+            *v++ = x;
+            *v++ = cap.y;
+            *v++ = z;
+            *v++ = 0.0f;
+            *v++ = normalY;
+            *v++ = 0.0f;
+            if (TexCoords)
+            {
+                *v++ = j < 0 ? 0.5f : (cosines[j] + 1.0f) * 0.5f;
+                *v++ = j < 0 ? 0.5f : (sines[j] + 1.0f) * 0.5f;
+            }
+        }
+        for (int j = 0; j < sectors; ++j)
+        {
+            *index++ = base;
+            *index++ = cap.top ? base + j + 1 : base + j + 2;
+            *index++ = cap.top ? base + j + 2 : base + j + 1;
+        }
+        base += sectors + 2;
+    }
+}
+
+// buildRevolution() with the sector counts of the game's meshes fixed at compile time: 36
+// for the spheres and targets, 50 for the arrow. Other counts, such as the coarser LOD
+// levels, are built with the run-time count.
+template <bool TexCoords, typename Profile>
+void buildRevolutionSpecialized(const Profile& profile, int sectorCount, float startAngle, float sweep,
+    const RevolutionCap* caps, int capCount, std::vector<float>& vertices, std::vector<unsigned int>& indices)
+{
+    switch (sectorCount)
+    {
+    case 36:
+        buildRevolution<TexCoords, 36>(profile, sectorCount, startAngle, sweep, caps, capCount, vertices, indices);
+        break;
+    case 50:
+        buildRevolution<TexCoords, 50>(profile, sectorCount, startAngle, sweep, caps, capCount, vertices, indices);
+        break;
+    default:
+        buildRevolution<TexCoords>(profile, sectorCount, startAngle, sweep, caps, capCount, vertices, indices);
+        break;
+    }
+}
+
+#endif /* revolution_h */
@@ -0,0 +1,126 @@
+//
+//  samplerCache.h
+//
+
+//
+
+#ifndef samplerCache_h
+#define samplerCache_h
+
+#include <glad/glad.h>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <iostream>
+#include "glHandle.h"
+
+// not in the core 3.3 glad headers; the values are shared by the EXT and ARB extensions and GL 4.6
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#endif
+#ifndef GL_MAX_TEXTURE_MAX_ANISOTROPY
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
+
+// addressing and filtering state, kept apart from the image it is applied to
+struct SamplerKey
+{
+    GLint wrapS;
+    GLint wrapT;
+    GLint minFilter;
+    GLint magFilter;
+    float anisotropy;   // 1 = off
+
+    bool operator==(const SamplerKey& other) const
+    {
+        return wrapS == other.wrapS && wrapT == other.wrapT && minFilter == other.minFilter
+            && magFilter == other.magFilter && anisotropy == other.anisotropy;
+    }
+};
+
+struct SamplerKeyHash
+{
+    size_t operator()(const SamplerKey& key) const
+    {
+        size_t h = std::hash<float>()(key.anisotropy);
+        GLint params[] = { key.wrapS, key.wrapT, key.minFilter, key.magFilter };
+        for (GLint p : params)
+            h ^= std::hash<GLint>()(p) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+// One GL sampler object per distinct sampler state. A sampler bound to a unit overrides the
+// bound texture's own wrap/filter parameters, so one uploaded image can be used with any of them.
+class SamplerCache
+{
+public:
+    // sampler object for the given state, created on first use; GL thread only
+    GLuint acquire(const SamplerKey& key)
+    {
+        auto it = samplers.find(key);
+        if (it != samplers.end())
+            return it->second;
+
+        if (maxAnisotropy < 0.0f)
+            queryAnisotropy();
+
+        GLSampler sampler = GLSampler::create(GL_HERE);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, key.wrapS);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, key.wrapT);
+        glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, key.minFilter);
+        glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, key.magFilter);
+        if (key.anisotropy > 1.0f && maxAnisotropy > 1.0f)
+            glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY, key.anisotropy < maxAnisotropy ? key.anisotropy : maxAnisotropy);
+
+        GLuint name = sampler;
+        samplers.emplace(key, std::move(sampler));
+        return name;
+    }
+
+    // anisotropy applied to samplers requested through loadTexture(); clamped to what the driver offers
+    void setDefaultAnisotropy(float anisotropy)
+    {
+        defaultAnisotropy = anisotropy;
+    }
+
+    float getDefaultAnisotropy() const
+    {
+        return defaultAnisotropy;
+    }
+
+    size_t count() const
+    {
+        return samplers.size();
+    }
+
+    // must run while the GL context is still current
+    void clear()
+    {
+        samplers.clear();
+    }
+
+private:
+    std::unordered_map<SamplerKey, GLSampler, SamplerKeyHash> samplers;
+    float defaultAnisotropy = 1.0f;
+    float maxAnisotropy = -1.0f;    // queried with the first sampler; 1 when unsupported
+
+    void queryAnisotropy()
+    {
+        maxAnisotropy = 1.0f;
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i)
+        {
+            const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (name && (strcmp(name, "GL_EXT_texture_filter_anisotropic") == 0 || strcmp(name, "GL_ARB_texture_filter_anisotropic") == 0))
+            {
+                glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+                break;
+            }
+        }
+    }
+};
+
+#endif /* samplerCache_h */
@@ -4,23 +4,101 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <vector>
+#include <unordered_map>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+#include "glHandle.h"
+
+// tessellation stages are GL 4.0; the core 3.3 glad headers lack their enums
+#ifndef GL_TESS_CONTROL_SHADER
+#define GL_TESS_EVALUATION_SHADER 0x8E87
+#define GL_TESS_CONTROL_SHADER 0x8E88
+#endif
+
+// Uniform calls sent to GL, skipped as unchanged (or inactive) and dropped because their
+// program was not current, for all programs.
+// GL thread only.
+class UniformCounter
+{
+public:
+    static UniformCounter& instance()
+    {
+        static UniformCounter counter;
+        return counter;
+    }
+
+    void issue()
+    {
+        ++issuedThisFrame;
+    }
+
+    void skip()
+    {
+        ++skippedThisFrame;
+    }
+
+    // a set on a program that was not current: a missing use() in the caller
+    void misdirect()
+    {
+        ++misdirectedThisFrame;
+    }
+
+    void endFrame()
+    {
+        lastFrameIssued = issuedThisFrame;
+        lastFrameSkipped = skippedThisFrame;
+        lastFrameMisdirected = misdirectedThisFrame;
+        issuedThisFrame = skippedThisFrame = misdirectedThisFrame = 0;
+    }
+
+    void printStats() const
+    {
+        std::cout << "Uniforms: " << lastFrameIssued << " calls issued, " << lastFrameSkipped
+            << " skipped, " << lastFrameMisdirected << " dropped as set before use() last frame" << std::endl;
+    }
+
+private:
+    unsigned long long issuedThisFrame = 0, skippedThisFrame = 0, misdirectedThisFrame = 0;
+    unsigned long long lastFrameIssued = 0, lastFrameSkipped = 0, lastFrameMisdirected = 0;
+
+    UniformCounter() {}
+    UniformCounter(const UniformCounter&) = delete;
+    UniformCounter& operator=(const UniformCounter&) = delete;
+};
+
+// slot of an active uniform in a Shader's table; -1 when the program has no such uniform
+struct ShaderUniform
+{
+    int slot = -1;
+
+    bool valid() const
+    {
+        return slot >= 0;
+    }
+};
+
 class Shader
 {
 public:
-    unsigned int ID;
+    GLProgram ID;               // deleted with the shader; converts to the program name
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+    // the tessellation stages need a GL 4.0 context (see tessellatedSurfaces.h)
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr,
+        const char* tessControlPath = nullptr, const char* tessEvaluationPath = nullptr)
     {
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
         std::string geometryCode;
+        std::string tessControlCode;
+        std::string tessEvaluationCode;
         std::ifstream vShaderFile;
         std::ifstream fShaderFile;
         std::ifstream gShaderFile;
@@ -52,6 +130,12 @@ public:
                 gShaderFile.close();
                 geometryCode = gShaderStream.str();
             }
+            // tessellation control and evaluation shaders come as a pair
+            if (tessControlPath != nullptr && tessEvaluationPath != nullptr)
+            {
+                tessControlCode = readFile(tessControlPath);
+                tessEvaluationCode = readFile(tessEvaluationPath);
+            }
         }
         catch (std::ifstream::failure& e)
         {
@@ -81,87 +165,321 @@ public:
             glCompileShader(geometry);
             checkCompileErrors(geometry, "GEOMETRY");
         }
+        // if tessellation shaders are given, compile both
+        bool tessellation = tessControlPath != nullptr && tessEvaluationPath != nullptr;
+        unsigned int tessControl = 0, tessEvaluation = 0;
+        if (tessellation)
+        {
+            const char* tcShaderCode = tessControlCode.c_str();
+            tessControl = glCreateShader(GL_TESS_CONTROL_SHADER);
+            glShaderSource(tessControl, 1, &tcShaderCode, NULL);
+            glCompileShader(tessControl);
+            checkCompileErrors(tessControl, "TESS_CONTROL");
+            const char* teShaderCode = tessEvaluationCode.c_str();
+            tessEvaluation = glCreateShader(GL_TESS_EVALUATION_SHADER);
+            glShaderSource(tessEvaluation, 1, &teShaderCode, NULL);
+            glCompileShader(tessEvaluation);
+            checkCompileErrors(tessEvaluation, "TESS_EVALUATION");
+        }
         // shader Program
-        ID = glCreateProgram();
+        ID = GLProgram::create(GL_HERE);
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
         if (geometryPath != nullptr)
             glAttachShader(ID, geometry);
+        if (tessellation)
+        {
+            glAttachShader(ID, tessControl);
+            glAttachShader(ID, tessEvaluation);
+        }
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        if (isLinked())
+            loadUniforms();
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
         if (geometryPath != nullptr)
             glDeleteShader(geometry);
+        if (tessellation)
+        {
+            glDeleteShader(tessControl);
+            glDeleteShader(tessEvaluation);
+        }
 
     }
+    // whether the program linked; a failed optional program can be dropped for a fallback
+    bool isLinked() const
+    {
+        GLint success = 0;
+        glGetProgramiv(ID, GL_LINK_STATUS, &success);
+        return success != 0;
+    }
     // activate the shader
     // ------------------------------------------------------------------------
+    // glUseProgram only when another program is current
     void use()
     {
-        glUseProgram(ID);
+        if (currentProgram() != ID.get())
+        {
+            glUseProgram(ID);
+            currentProgram() = ID.get();
+        }
+    }
+    ~Shader()
+    {
+        if (currentProgram() == ID.get())
+            currentProgram() = 0;
+    }
+    // precomputed handle of an active uniform, for setters called every frame
+    ShaderUniform uniform(const char* name) const
+    {
+        ShaderUniform handle;
+        auto it = uniformSlots.find(hashName(name));
+        if (it != uniformSlots.end() && uniforms[it->second].name == name)
+            handle.slot = it->second;
+        return handle;
     }
-    // utility uniform functions
+    ShaderUniform uniform(const std::string& name) const
+    {
+        return uniform(name.c_str());
+    }
+    // names of the active uniforms, one per array element
+    std::vector<std::string> activeUniforms() const
+    {
+        std::vector<std::string> names;
+        for (const UniformSlot& slot : uniforms)
+            names.push_back(slot.name);
+        return names;
+    }
+    // utility uniform functions. Each takes a name or a handle from uniform(); a value equal
+    // to the last one set on that uniform is not sent again.
     // ------------------------------------------------------------------------
-    void setBool(const std::string& name, bool value) const
+    void setBool(ShaderUniform u, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        setInt(u, (int)value);
     }
+    void setBool(const char* name, bool value) const { setBool(uniform(name), value); }
+    void setBool(const std::string& name, bool value) const { setBool(uniform(name), value); }
     // ------------------------------------------------------------------------
-    void setInt(const std::string& name, int value) const
+    void setInt(ShaderUniform u, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        GLint location = changed(u, &value, sizeof(value));
+        if (location >= 0)
+            glUniform1i(location, value);
     }
+    void setInt(const char* name, int value) const { setInt(uniform(name), value); }
+    void setInt(const std::string& name, int value) const { setInt(uniform(name), value); }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string& name, float value) const
+    void setFloat(ShaderUniform u, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        GLint location = changed(u, &value, sizeof(value));
+        if (location >= 0)
+            glUniform1f(location, value);
     }
+    void setFloat(const char* name, float value) const { setFloat(uniform(name), value); }
+    void setFloat(const std::string& name, float value) const { setFloat(uniform(name), value); }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string& name, const glm::vec2& value) const
+    void setVec2(ShaderUniform u, const glm::vec2& value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        GLint location = changed(u, &value[0], 2 * sizeof(float));
+        if (location >= 0)
+            glUniform2fv(location, 1, &value[0]);
     }
+    void setVec2(const char* name, const glm::vec2& value) const { setVec2(uniform(name), value); }
+    void setVec2(const std::string& name, const glm::vec2& value) const { setVec2(uniform(name), value); }
     void setVec2(const std::string& name, float x, float y) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        setVec2(uniform(name), glm::vec2(x, y));
     }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string& name, const glm::vec3& value) const
+    void setVec3(ShaderUniform u, const glm::vec3& value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        GLint location = changed(u, &value[0], 3 * sizeof(float));
+        if (location >= 0)
+            glUniform3fv(location, 1, &value[0]);
     }
+    void setVec3(const char* name, const glm::vec3& value) const { setVec3(uniform(name), value); }
+    void setVec3(const std::string& name, const glm::vec3& value) const { setVec3(uniform(name), value); }
     void setVec3(const std::string& name, float x, float y, float z) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        setVec3(uniform(name), glm::vec3(x, y, z));
     }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string& name, const glm::vec4& value) const
+    void setVec4(ShaderUniform u, const glm::vec4& value) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        GLint location = changed(u, &value[0], 4 * sizeof(float));
+        if (location >= 0)
+            glUniform4fv(location, 1, &value[0]);
     }
+    void setVec4(const char* name, const glm::vec4& value) const { setVec4(uniform(name), value); }
+    void setVec4(const std::string& name, const glm::vec4& value) const { setVec4(uniform(name), value); }
     void setVec4(const std::string& name, float x, float y, float z, float w)
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        setVec4(uniform(name), glm::vec4(x, y, z, w));
+    }
+    // ------------------------------------------------------------------------
+    void setMat2(ShaderUniform u, const glm::mat2& mat) const
+    {
+        GLint location = changed(u, &mat[0][0], 4 * sizeof(float));
+        if (location >= 0)
+            glUniformMatrix2fv(location, 1, GL_FALSE, &mat[0][0]);
     }
+    void setMat2(const char* name, const glm::mat2& mat) const { setMat2(uniform(name), mat); }
+    void setMat2(const std::string& name, const glm::mat2& mat) const { setMat2(uniform(name), mat); }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string& name, const glm::mat2& mat) const
+    void setMat3(ShaderUniform u, const glm::mat3& mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        GLint location = changed(u, &mat[0][0], 9 * sizeof(float));
+        if (location >= 0)
+            glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]);
     }
+    void setMat3(const char* name, const glm::mat3& mat) const { setMat3(uniform(name), mat); }
+    void setMat3(const std::string& name, const glm::mat3& mat) const { setMat3(uniform(name), mat); }
     // ------------------------------------------------------------------------
-    void setMat3(const std::string& name, const glm::mat3& mat) const
+    void setMat4(ShaderUniform u, const glm::mat4& mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        GLint location = changed(u, &mat[0][0], 16 * sizeof(float));
+        if (location >= 0)
+            glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]);
     }
+    void setMat4(const char* name, const glm::mat4& mat) const { setMat4(uniform(name), mat); }
+    void setMat4(const std::string& name, const glm::mat4& mat) const { setMat4(uniform(name), mat); }
     // ------------------------------------------------------------------------
-    void setMat4(const std::string& name, const glm::mat4& mat) const
+    // Sets u to the value last set on from's fromUniform, if any; the two must have the same type.
+    // Lets one program take over another's uniforms without reading them back from GL.
+    void copyUniform(ShaderUniform u, const Shader& from, ShaderUniform fromUniform) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        if (u.slot < 0 || fromUniform.slot < 0)
+            return;
+        const UniformSlot& source = from.uniforms[fromUniform.slot];
+        if (!source.known || source.type != uniforms[u.slot].type)
+            return;
+        GLint location = changed(u, source.value, source.bytes);
+        if (location < 0)
+            return;
+        const GLfloat* f = (const GLfloat*)source.value;
+        switch (source.type)
+        {
+        case GL_FLOAT: glUniform1fv(location, 1, f); break;
+        case GL_FLOAT_VEC2: glUniform2fv(location, 1, f); break;
+        case GL_FLOAT_VEC3: glUniform3fv(location, 1, f); break;
+        case GL_FLOAT_VEC4: glUniform4fv(location, 1, f); break;
+        case GL_FLOAT_MAT2: glUniformMatrix2fv(location, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT3: glUniformMatrix3fv(location, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT4: glUniformMatrix4fv(location, 1, GL_FALSE, f); break;
+        default: glUniform1iv(location, 1, (const GLint*)source.value); break;  // int, bool, samplers
+        }
     }
 
 private:
+    // an active uniform with the value last set through this Shader
+    struct UniformSlot
+    {
+        std::string name;
+        GLint location = -1;
+        GLenum type = 0;
+        bool known = false;         // false until first set; GL's own value is not read back
+        bool misdirected = false;   // already reported as set while another program was current
+        size_t bytes = 0;
+        unsigned char value[16 * sizeof(float)];
+    };
+
+    mutable std::vector<UniformSlot> uniforms;
+    std::unordered_map<uint64_t, int> uniformSlots;     // hash of the name to its slot
+
+    static uint64_t hashName(const char* name)
+    {
+        uint64_t hash = 1469598103934665603ull;     // FNV-1a
+        for (; *name; ++name)
+            hash = (hash ^ (unsigned char)*name) * 1099511628211ull;
+        return hash;
+    }
+
+    // Table of the linked program's active uniforms. Arrays of basic types are reported once
+    // as name[0]; each element gets its own slot.
+    void loadUniforms()
+    {
+        GLint count = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        for (GLint i = 0; i < count; ++i)
+        {
+            GLchar name[256];
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, sizeof(name), nullptr, &size, &type, name);
+            std::string base = name;
+            if (base.compare(0, 3, "gl_") == 0)
+                continue;
+            if (size > 1 && base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0)
+                base.erase(base.size() - 3);
+            for (GLint e = 0; e < size; ++e)
+            {
+                UniformSlot slot;
+                slot.name = size > 1 ? base + "[" + std::to_string(e) + "]" : base;
+                slot.location = glGetUniformLocation(ID, slot.name.c_str());
+                slot.type = type;
+                if (slot.location < 0)
+                    continue;
+                uniformSlots[hashName(slot.name.c_str())] = (int)uniforms.size();
+                uniforms.push_back(slot);
+            }
+        }
+    }
+
+    // the program last made current by use(); nothing else calls glUseProgram
+    static GLuint& currentProgram()
+    {
+        static GLuint program = 0;
+        return program;
+    }
+
+    // Location to send value to, or -1 when the uniform is not active or already holds it.
+    // glUniform goes to the current program, so a set while another one is current is
+    // dropped instead of landing on (and invalidating the shadow of) that one. That is a
+    // caller bug (a missing use()), so it is counted apart from redundant sets and debug
+    // builds report each such uniform once.
+    GLint changed(ShaderUniform u, const void* value, size_t bytes) const
+    {
+        if (u.slot < 0)
+        {
+            UniformCounter::instance().skip();
+            return -1;
+        }
+        UniformSlot& slot = uniforms[u.slot];
+        if (currentProgram() != ID.get())
+        {
+            UniformCounter::instance().misdirect();
+#ifndef NDEBUG
+            if (!slot.misdirected)
+                std::cerr << "Shader: " << slot.name << " set on program " << ID.get() << " while program "
+                    << currentProgram() << " is current; call use() first. The value was dropped." << std::endl;
+#endif
+            slot.misdirected = true;
+            return -1;
+        }
+        if (slot.known && slot.bytes == bytes && memcmp(slot.value, value, bytes) == 0)
+        {
+            UniformCounter::instance().skip();
+            return -1;
+        }
+        memcpy(slot.value, value, bytes);
+        slot.bytes = bytes;
+        slot.known = true;
+        UniformCounter::instance().issue();
+        return slot.location;
+    }
+
+    static std::string readFile(const char* path)
+    {
+        std::ifstream file;
+        file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        file.open(path);
+        std::stringstream stream;
+        stream << file.rdbuf();
+        file.close();
+        return stream.str();
+    }
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
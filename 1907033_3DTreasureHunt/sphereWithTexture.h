@@ -7,12 +7,29 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "shader.h"
-
-#define PI 3.14159265359
+#include "geometryArena.h"
+#include "drawUniforms.h"
+#include "lod.h"
+#include "revolution.h"
+#include "textureArray.h"
+#include "tessellatedSurfaces.h"
 
 using namespace std;
 
+// Textured sphere built ring by ring from the north pole (+y)
+inline void buildTexturedSphere(float radius, int sectors, int stacks, vector<float>& vertices, vector<unsigned int>& indices)
+{
+    buildRevolutionSpecialized<true>(SphereProfile(radius, stacks, stacks + 1), sectors,
+        0.0f, (float)(2 * PI), nullptr, 0, vertices, indices);
+}
 
+// Indices of the upper half of that sphere, which come first: the fan around the pole and two
+// triangles per quad of the next stacks / 2 - 1 stacks. HemiWithTex draws just this range.
+inline size_t hemisphereIndexCount(int sectors, int stacks)
+{
+    int halfStacks = stacks / 2;
+    return halfStacks < 1 ? 0 : (size_t)sectors * 3 * (2 * halfStacks - 1);
+}
 
 class SphereWithTexture
 {
@@ -21,6 +38,7 @@ public:
     glm::vec3 diffuse;
     glm::vec3 specular;
     float shininess;
+    MaterialId material = MaterialTable::DEFAULT;  // entry of the colours above in the material table (materialTable.h)
 
     // Texture maps
     unsigned int diffuseMap;
@@ -38,186 +56,75 @@ public:
         ambient(amb), diffuse(diff), specular(spec), shininess(shiny),
         diffuseMap(diffuseTexture), specularMap(specularTexture), verticesStride(32)
     {
-        buildCoordinatesAndIndices();
-        buildVertices();
-        setupVAO();
+        material = MaterialTable::instance().add(ambient, diffuse, specular, shininess);
+        buildMesh();
+        uploadMesh();
     }
 
     ~SphereWithTexture()
     {
-        glDeleteVertexArrays(1, &sphereVAO);
+        lods.release();
     }
+    SphereWithTexture(const SphereWithTexture&) = delete;
+    SphereWithTexture& operator=(const SphereWithTexture&) = delete;
 
-    // Drawing method with textures
-    void drawSphere(Shader& lightingShader, glm::mat4 model,  glm::vec3 viewPos) const
+    // Drawing method with textures; lodLevel (per drawn instance) enables level of detail
+    void drawSphere(Shader& shader, glm::mat4 model, int* lodLevel = nullptr) const
     {
-        lightingShader.use();
-
-        // Pass material properties
-        lightingShader.setVec3("material.ambient", this->ambient);
-        lightingShader.setVec3("material.diffuseColor", this->diffuse); // Surface diffuse color
-        lightingShader.setVec3("material.specularColor", this->specular); // Surface specular color
-        lightingShader.setFloat("material.shininess", this->shininess);
+        drawSphere(shader, model, material, diffuseMap, specularMap, lodLevel);
+    }
 
-        // Pass texture units
-        lightingShader.setInt("material.diffuse", 0);  // Texture unit 0 for diffuse
-        lightingShader.setInt("material.specular", 1); // Texture unit 1 for specular
+    // one draw with its own material and maps, so a shared mesh (see meshRegistry.h) serves
+    // objects of any look without being changed
+    void drawSphere(Shader& shader, glm::mat4 model, MaterialId drawMaterial, unsigned int diffuseTexture,
+        unsigned int specularTexture, int* lodLevel = nullptr) const
+    {
+        // on GPUs that tessellate, the tessellation program stands in for the lit textured shaders
+        Shader* tessellated = TessellatedSurfaces::instance().replacement(shader);
+        Shader& lightingShader = tessellated ? *tessellated : shader;
+        lightingShader.use();
 
         // Bind textures
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, specularMap);
+        bindMaterialTextures(lightingShader, diffuseTexture, specularTexture);
 
-        // Set transformation matrices
-        lightingShader.setMat4("model", model);
-
-        // Set view position
-        lightingShader.setVec3("viewPos", viewPos);
+        // Model matrix and material of this draw
+        DrawUniforms::instance().push(model, drawMaterial);
 
         // Draw the sphere
-        glBindVertexArray(sphereVAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        if (tessellated)
+            TessellatedSurfaces::instance().drawSphere(radius);
+        else
+            GeometryArena::instance().draw(LodSelector::instance().choose(lods, model, lodLevel));
     }
 
 private:
     // Member variables
-    unsigned int sphereVAO;
+    LodChain lods;              // ranges in the shared geometry arena, finest first
     float radius;
     int sectorCount; // Longitude
     int stackCount;  // Latitude
     vector<float> vertices;  // Interleaved vertex data
-    vector<float> normals;   // Normal vectors
-    vector<float> texCoords; // Texture coordinates
-    vector<float> coordinates; // Vertex positions
     vector<unsigned int> indices; // Indices for element drawing
     int verticesStride;      // 32 bytes (3 pos + 3 norm + 2 tex)
 
-    // Builds coordinates, normals, and texture coordinates
-    void buildCoordinatesAndIndices()
+    // Builds interleaved positions, normals and texture coordinates with their indices
+    void buildMesh()
     {
-        float x, y, z, xz;
-        float nx, ny, nz, lengthInv = 1.0f / radius;
-        float s, t;
-
-        float sectorStep = 2 * PI / sectorCount;
-        float stackStep = PI / stackCount;
-        float sectorAngle, stackAngle;
-
-        for (int i = 0; i <= stackCount; ++i)
-        {
-            stackAngle = PI / 2 - i * stackStep; // From pi/2 to -pi/2
-            xz = radius * cosf(stackAngle);
-            y = radius * sinf(stackAngle);
-
-            for (int j = 0; j <= sectorCount; ++j)
-            {
-                sectorAngle = j * sectorStep;
-
-                // Position
-                x = xz * cosf(sectorAngle);
-                z = xz * sinf(sectorAngle);
-                coordinates.push_back(x);
-                coordinates.push_back(y);
-                coordinates.push_back(z);
-
-                // Normalized normals
-                nx = x * lengthInv;
-                ny = y * lengthInv;
-                nz = z * lengthInv;
-                normals.push_back(nx);
-                normals.push_back(ny);
-                normals.push_back(nz);
-
-                // Texture coordinates
-                s = (float)j / sectorCount;
-                t = (float)i / stackCount;
-                texCoords.push_back(s);
-                texCoords.push_back(t);
-            }
-        }
-
-        // Indices
-        int k1, k2;
-        for (int i = 0; i < stackCount; ++i)
-        {
-            k1 = i * (sectorCount + 1);     // Beginning of current stack
-            k2 = k1 + sectorCount + 1;      // Beginning of next stack
-
-            for (int j = 0; j < sectorCount; ++j, ++k1, ++k2)
-            {
-                if (i != 0) // Not the top stack
-                {
-                    indices.push_back(k1);
-                    indices.push_back(k2);
-                    indices.push_back(k1 + 1);
-                }
-
-                if (i != (stackCount - 1)) // Not the bottom stack
-                {
-                    indices.push_back(k1 + 1);
-                    indices.push_back(k2);
-                    indices.push_back(k2 + 1);
-                }
-            }
-        }
+        build(sectorCount, stackCount, vertices, indices);
     }
 
-    // Populates vertices into a flat buffer for OpenGL
-    void buildVertices()
+    void build(int sectors, int stacks, vector<float>& outVertices, vector<unsigned int>& outIndices) const
     {
-        vertices.clear();
-        size_t vertexCount = coordinates.size() / 3;
-
-        for (size_t i = 0; i < vertexCount; ++i)
-        {
-            // Position
-            vertices.push_back(coordinates[i * 3]);
-            vertices.push_back(coordinates[i * 3 + 1]);
-            vertices.push_back(coordinates[i * 3 + 2]);
-
-            // Normal
-            vertices.push_back(normals[i * 3]);
-            vertices.push_back(normals[i * 3 + 1]);
-            vertices.push_back(normals[i * 3 + 2]);
-
-            // Texture coordinates
-            vertices.push_back(texCoords[i * 2]);
-            vertices.push_back(texCoords[i * 2 + 1]);
-        }
+        buildTexturedSphere(radius, sectors, stacks, outVertices, outIndices);
     }
 
-    // Sets up the VAO and VBO
-    void setupVAO()
+    // Copies the vertices and indices, and coarser tessellations down to 8 x 4, into the shared geometry
+    // arena. The upper half stays a range of its own, so a HemiWithTex of the same shape shares the blocks.
+    void uploadMesh()
     {
-        glGenVertexArrays(1, &sphereVAO);
-        glBindVertexArray(sphereVAO);
-
-        // Create VBO
-        unsigned int sphereVBO;
-        glGenBuffers(1, &sphereVBO);
-        glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
-
-        // Create EBO
-        unsigned int sphereEBO;
-        glGenBuffers(1, &sphereEBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // Configure vertex attributes
-        int stride = verticesStride;
-        glEnableVertexAttribArray(0); // Position
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
-
-        glEnableVertexAttribArray(1); // Normal
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
-
-        glEnableVertexAttribArray(2); // Texture coordinates
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
-
-        glBindVertexArray(0);
+        buildLodChain(lods, "SphereWithTexture", vertices, indices, sectorCount, stackCount, 8, 4,
+            [this](int sectors, int stacks, vector<float>& v, vector<unsigned int>& i) { build(sectors, stacks, v, i); },
+            hemisphereIndexCount);
     }
 };
 
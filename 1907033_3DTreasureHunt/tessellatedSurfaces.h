@@ -0,0 +1,319 @@
+//
+//  tessellatedSurfaces.h
+//
+
+//
+
+#ifndef tessellatedSurfaces_h
+#define tessellatedSurfaces_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <memory>
+#include <iostream>
+#include "shader.h"
+#include "glHandle.h"
+#include "frameUniforms.h"
+#include "drawUniforms.h"
+#include "materialTable.h"
+#include "geometryArena.h"
+
+// GL 4.0 names the core 3.3 glad headers lack
+#ifndef GL_PATCHES
+#define GL_PATCHES 0x000E
+#endif
+#ifndef GL_PATCH_VERTICES
+#define GL_PATCH_VERTICES 0x8E72
+#endif
+#ifndef GL_MAX_TESS_GEN_LEVEL
+#define GL_MAX_TESS_GEN_LEVEL 0x8E7E
+#endif
+
+// surfaces the evaluation shader can place; the values are the shaders' `shape` uniform
+enum class TessellatedShape
+{
+    Sphere = 0,     // radius, first t, last t (0 = north pole, 1 = south pole)
+    Frustum = 1,    // base radius, top radius, height; centred on the origin
+    Cone = 2,       // radius, height; standing on y = 0
+    Disk = 3        // radius, y, +1 facing up or -1 facing down
+};
+
+// Round primitives tessellated on the GPU. A few coarse quad patches in the (around, along)
+// parameter domain are drawn as GL_PATCHES; the control shader subdivides each edge by its
+// on-screen size and the evaluation shader puts every new vertex on the exact surface, so
+// silhouettes stay smooth up close and far objects cost a handful of triangles without any
+// LodChain. Needs GL 4.0 or ARB_tessellation_shader; without them (or when the program
+// fails to link) isActive() stays false and the primitives draw their arena meshes.
+//
+// The program lights with fragmentShaderForPhongShadingWithTexture.fs and reads the camera and
+// lights from the frame uniform block. It stands in for the shaders given to pairWith(), whose
+// other uniforms (blending and texture array toggles) it copies the first time it replaces one
+// of them in a frame. GL thread only.
+class TessellatedSurfaces
+{
+public:
+    static TessellatedSurfaces& instance()
+    {
+        static TessellatedSurfaces surfaces;
+        return surfaces;
+    }
+
+    // After the glad loader: checks the context, fetches glPatchParameteri through load
+    // and builds the program. Returns whether the path can be used.
+    bool init(GLADloadproc load)
+    {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        if (major < 4 && !hasExtension("GL_ARB_tessellation_shader"))
+        {
+            std::cout << "Hardware tessellation: GL " << major << "." << minor
+                << " has no tessellation shaders, round objects use their meshes" << std::endl;
+            return false;
+        }
+        patchParameteri = (PatchParameteriProc)load("glPatchParameteri");
+        if (!patchParameteri)
+        {
+            std::cout << "Hardware tessellation: glPatchParameteri not found, round objects use their meshes" << std::endl;
+            return false;
+        }
+
+        program.reset(new Shader("vertexShaderForTessellatedSurface.vs", "fragmentShaderForPhongShadingWithTexture.fs", nullptr,
+            "tessControlShaderForTessellatedSurface.tcs", "tessEvaluationShaderForTessellatedSurface.tes"));
+        if (!program->isLinked())
+        {
+            std::cout << "Hardware tessellation: program did not link, round objects use their meshes" << std::endl;
+            program.reset();
+            return false;
+        }
+        FrameUniforms::attach(*program);
+        DrawUniforms::attach(*program);
+        MaterialTable::attach(*program);
+        GLint maxLevel = 64;
+        glGetIntegerv(GL_MAX_TESS_GEN_LEVEL, &maxLevel);
+        maxTessLevel = (float)maxLevel;
+
+        buildPatches();
+        available = true;
+        std::cout << "Hardware tessellation: available (GL " << major << "." << minor << ", up to "
+            << maxLevel << " segments per patch edge)" << std::endl;
+        return true;
+    }
+
+    bool enabled = true;
+    float pixelsPerSegment = 6.0f;  // target on-screen length of one tessellated segment
+
+    bool isActive() const
+    {
+        return available && enabled;
+    }
+
+    // the shaders this program may stand in for; they must use the same fragment shader
+    void pairWith(const Shader& shader)
+    {
+        paired.push_back(&shader);
+    }
+
+    void setViewportHeight(int height)
+    {
+        viewportHeight = (float)height;
+    }
+
+    // The program to draw with instead of shader, made current with shader's frame uniforms,
+    // or nullptr when the caller should draw its mesh with shader
+    Shader* replacement(const Shader& shader)
+    {
+        if (!isActive())
+            return nullptr;
+        bool isPaired = false;
+        for (const Shader* candidate : paired)
+            isPaired = isPaired || candidate == &shader;
+        if (!isPaired)
+            return nullptr;
+
+        program->use();
+        if (syncedFrom != &shader)
+        {
+            copyFrameUniforms(shader);
+            syncedFrom = &shader;
+        }
+        return program.get();
+    }
+
+    // Draw calls for the program returned by replacement(), after the caller pushed the model
+    // matrix and material id. Each is one draw of the coarse patch grid for the surface.
+    void drawSphere(float radius, float firstT = 0.0f, float lastT = 1.0f)
+    {
+        draw(TessellatedShape::Sphere, glm::vec4(radius, firstT, lastT, 0.0f));
+    }
+
+    // side only; the caps are disks
+    void drawFrustum(float baseRadius, float topRadius, float height)
+    {
+        draw(TessellatedShape::Frustum, glm::vec4(baseRadius, topRadius, height, 0.0f));
+    }
+
+    void drawCone(float radius, float height)
+    {
+        draw(TessellatedShape::Cone, glm::vec4(radius, height, 0.0f, 0.0f));
+    }
+
+    void drawDisk(float radius, float y, bool facingUp)
+    {
+        draw(TessellatedShape::Disk, glm::vec4(radius, y, facingUp ? 1.0f : -1.0f, 0.0f));
+    }
+
+    // once per frame; frame uniforms are copied again on the next replacement()
+    void endFrame()
+    {
+        lastFrameDraws = drawsThisFrame;
+        lastFramePatches = patchesThisFrame;
+        drawsThisFrame = patchesThisFrame = 0;
+        syncedFrom = nullptr;
+    }
+
+    void printStats() const
+    {
+        if (!available)
+        {
+            std::cout << "Hardware tessellation: not available, round objects use their meshes" << std::endl;
+            return;
+        }
+        std::cout << "Hardware tessellation " << (enabled ? "on" : "off") << ": " << lastFrameDraws << " draws, "
+            << lastFramePatches << " patches last frame, " << pixelsPerSegment << " pixels per segment" << std::endl;
+    }
+
+    // must run while the GL context is still current
+    void release()
+    {
+        program.reset();
+        patchVao.reset();
+        patchVbo.reset();
+        uniformCopies.clear();
+        available = false;
+    }
+
+private:
+    typedef void (APIENTRYP PatchParameteriProc)(GLenum pname, GLint value);
+
+    // patch grids in patchVbo: the sphere curves both ways, the other surfaces only around
+    static const int SECTOR_PATCHES = 8;
+    static const int SPHERE_STACK_PATCHES = 4;
+
+    bool available = false;
+    PatchParameteriProc patchParameteri = nullptr;
+    std::unique_ptr<Shader> program;
+    GLVertexArray patchVao;
+    GLBuffer patchVbo;
+    GLint spherePatchVertices = 0;
+    GLint straightPatchVertices = 0;
+    float maxTessLevel = 64.0f;
+    float viewportHeight = 1.0f;
+    std::vector<const Shader*> paired;
+    const Shader* syncedFrom = nullptr;
+    // (ours, theirs) handles of the uniforms copied from each paired shader
+    std::unordered_map<const Shader*, std::vector<std::pair<ShaderUniform, ShaderUniform>>> uniformCopies;
+    unsigned long long drawsThisFrame = 0, patchesThisFrame = 0;
+    unsigned long long lastFrameDraws = 0, lastFramePatches = 0;
+
+    static bool hasExtension(const char* wanted)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i)
+        {
+            const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (name && strcmp(name, wanted) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    // Quads of (around, along) parameters, 4 corners each in the order the control shader
+    // expects: the sphere grid, then a grid with one patch along for the straight-sided surfaces
+    void buildPatches()
+    {
+        std::vector<float> corners;
+        auto addGrid = [&corners](int around, int along)
+        {
+            for (int j = 0; j < along; ++j)
+                for (int i = 0; i < around; ++i)
+                {
+                    float s0 = (float)i / around, s1 = (float)(i + 1) / around;
+                    float t0 = (float)j / along, t1 = (float)(j + 1) / along;
+                    float quad[] = { s0, t0, s1, t0, s1, t1, s0, t1 };
+                    corners.insert(corners.end(), quad, quad + 8);
+                }
+        };
+        addGrid(SECTOR_PATCHES, SPHERE_STACK_PATCHES);
+        spherePatchVertices = (GLint)(corners.size() / 2);
+        addGrid(SECTOR_PATCHES, 1);
+        straightPatchVertices = (GLint)(corners.size() / 2) - spherePatchVertices;
+
+        patchVao = GLVertexArray::create(GL_HERE);
+        patchVbo = GLBuffer::create(GL_HERE);
+        glBindVertexArray(patchVao);
+        glBindBuffer(GL_ARRAY_BUFFER, patchVbo);
+        glBufferData(GL_ARRAY_BUFFER, corners.size() * sizeof(float), corners.data(), GL_STATIC_DRAW);
+        patchVbo.setBytes(corners.size() * sizeof(float));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glBindVertexArray(0);
+        GeometryArena::instance().invalidateBinding();
+    }
+
+    void draw(TessellatedShape shape, const glm::vec4& params)
+    {
+        program->setInt("shape", (int)shape);
+        program->setVec4("shapeParams", params);
+        program->setFloat("viewportHeight", viewportHeight);
+        program->setFloat("pixelsPerSegment", pixelsPerSegment);
+        program->setFloat("maxTessLevel", maxTessLevel);
+
+        bool sphere = shape == TessellatedShape::Sphere;
+        GLint first = sphere ? 0 : spherePatchVertices;
+        GLint count = sphere ? spherePatchVertices : straightPatchVertices;
+        glBindVertexArray(patchVao);
+        GeometryArena::instance().invalidateBinding();
+        patchParameteri(GL_PATCH_VERTICES, 4);
+        glDrawArrays(GL_PATCHES, first, count);
+        ++drawsThisFrame;
+        patchesThisFrame += count / 4;
+    }
+
+    // Everything the source shader has set (the model matrix and material come from the per-draw
+    // uniform buffer). Values come from the shaders' shadow copies, and ones our program already
+    // holds are not sent again.
+    void copyFrameUniforms(const Shader& source)
+    {
+        auto it = uniformCopies.find(&source);
+        if (it == uniformCopies.end())
+            it = uniformCopies.emplace(&source, listUniformCopies(source)).first;
+
+        for (const auto& copy : it->second)
+            program->copyUniform(copy.first, source, copy.second);
+    }
+
+    std::vector<std::pair<ShaderUniform, ShaderUniform>> listUniformCopies(const Shader& source) const
+    {
+        std::vector<std::pair<ShaderUniform, ShaderUniform>> copies;
+        for (const std::string& name : source.activeUniforms())
+        {
+            ShaderUniform ours = program->uniform(name);
+            if (ours.valid())
+                copies.push_back(std::make_pair(ours, source.uniform(name)));
+        }
+        return copies;
+    }
+
+    TessellatedSurfaces() {}
+    TessellatedSurfaces(const TessellatedSurfaces&) = delete;
+    TessellatedSurfaces& operator=(const TessellatedSurfaces&) = delete;
+};
+
+#endif /* tessellatedSurfaces_h */
@@ -0,0 +1,210 @@
+//
+//  textureArray.h
+//
+
+//
+
+#ifndef textureArray_h
+#define textureArray_h
+
+#include <glad/glad.h>
+#include <map>
+#include <tuple>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <iostream>
+#include "shader.h"
+#include "textureCache.h"
+#include "stb_image.h"
+
+// texture unit the array stays bound to while the mode is on; units 0 and 1 keep the per-draw maps
+const int TEXTURE_ARRAY_UNIT = 2;
+
+// Optional material mode: the images of the largest group of texture views that share size,
+// channel count and sampler state are copied into the layers of one GL_TEXTURE_2D_ARRAY. Draws whose diffuse
+// map lives in the array only set a layer uniform, so the array is bound once per frame instead
+// of two glBindTexture calls per draw. Textures outside the group keep the usual 2D path.
+class MaterialTextureArray
+{
+public:
+    static MaterialTextureArray& instance()
+    {
+        static MaterialTextureArray materials;
+        return materials;
+    }
+
+    // points the shader's sampler2DArray at its own unit; left at 0 it would clash with diffuseMap
+    static void attach(Shader& shader)
+    {
+        shader.use();
+        shader.setInt("materialLayers", TEXTURE_ARRAY_UNIT);
+        shader.setBool("useTextureArray", false);
+    }
+
+    bool isActive() const
+    {
+        return active && arrayId != 0;
+    }
+
+    // the array is built the first time the mode is switched on
+    void setActive(bool on)
+    {
+        if (on && !built)
+            build();
+        active = on;
+        std::cout << "Texture array materials " << (isActive() ? "on" : "off") << std::endl;
+    }
+
+    void toggle()
+    {
+        setActive(!active);
+    }
+
+    // the one texture binding the packed materials need per frame
+    void bindForFrame() const
+    {
+        if (!isActive())
+            return;
+        glActiveTexture(GL_TEXTURE0 + TEXTURE_ARRAY_UNIT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, arrayId);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // layer holding the given view's image, or -1 when it is not packed (or the mode is off)
+    int layerOf(unsigned int viewId) const
+    {
+        if (!isActive())
+            return -1;
+        auto it = layers.find(viewId);
+        return it == layers.end() ? -1 : it->second;
+    }
+
+    // packs the current cache contents; must run on the GL thread
+    void build()
+    {
+        built = true;
+        release();
+
+        TextureCache& cache = TextureCache::instance();
+        cache.finishPending();
+
+        // group by everything that has to match inside one array
+        typedef std::tuple<int, int, int, GLint, GLint, GLint, GLint> GroupKey;
+        std::map<GroupKey, std::vector<const TextureView*>> groups;
+        for (const TextureView& view : cache.allViews())
+        {
+            const TextureEntry& texture = *view.image;
+            if (!texture.ready || texture.width == 0)
+                continue;
+            GroupKey key(texture.width, texture.height, texture.channels,
+                view.key.wrapS, view.key.wrapT, view.key.minFilter, view.key.magFilter);
+            groups[key].push_back(&view);
+        }
+
+        const std::vector<const TextureView*>* best = nullptr;
+        for (const auto& group : groups)
+            if (!best || group.second.size() > best->size())
+                best = &group.second;
+        if (!best || best->size() < 2)
+        {
+            std::cout << "Texture array: no two cached textures share a size, nothing to pack" << std::endl;
+            return;
+        }
+
+        GLint maxLayers = 256;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+        const TextureKey& sampler = best->front()->key;
+        const TextureEntry& first = *best->front()->image;
+        int layerCount = (int)best->size() < maxLayers ? (int)best->size() : maxLayers;
+
+        GLenum format = GL_RGB;
+        if (first.channels == 1)
+            format = GL_RED;
+        else if (first.channels == 3)
+            format = GL_RGB;
+        else if (first.channels == 4)
+            format = GL_RGBA;
+
+        arrayId = GLTexture::create(GL_HERE);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, arrayId);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, sampler.wrapS);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, sampler.wrapT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, sampler.minFilter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, sampler.magFilter);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format, first.width, first.height, layerCount, 0, format, GL_UNSIGNED_BYTE, NULL);
+        size_t texelBytes = first.channels == 3 ? 4 : first.channels;
+        arrayId.setBytes((size_t)first.width * first.height * texelBytes * layerCount * 4 / 3);    // with the mip chain
+
+        // GL 3.3 cannot copy between texture objects, so each layer is decoded from its file again
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        int layer = 0;
+        std::unordered_map<unsigned int, int> imageLayers;     // texture name -> layer, for views sharing an image
+        for (const TextureView* view : *best)
+        {
+            auto shared = imageLayers.find(view->image->id);
+            if (shared != imageLayers.end())
+            {
+                layers[view->viewId] = shared->second;
+                continue;
+            }
+            if (layer == layerCount)
+                break;
+            int width, height, channels;
+            unsigned char* data = stbi_load(view->key.path.c_str(), &width, &height, &channels, 0);
+            if (!data || width != first.width || height != first.height || channels != first.channels)
+            {
+                stbi_image_free(data);
+                continue;
+            }
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format, GL_UNSIGNED_BYTE, data);
+            stbi_image_free(data);
+            layers[view->viewId] = layer;
+            imageLayers[view->image->id] = layer;
+            std::cout << "Texture array layer " << layer << ": " << view->key.path << std::endl;
+            ++layer;
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        std::cout << "Texture array: " << layer << " layers of " << first.width << "x" << first.height
+            << ", draws using them share one binding" << std::endl;
+    }
+
+    // must run while the GL context is still current
+    void release()
+    {
+        arrayId.reset();
+        layers.clear();
+    }
+
+private:
+    GLTexture arrayId;
+    std::unordered_map<unsigned int, int> layers;   // texture view id -> array layer
+    bool active = false;
+    bool built = false;
+
+    MaterialTextureArray() {}
+    MaterialTextureArray(const MaterialTextureArray&) = delete;
+    MaterialTextureArray& operator=(const MaterialTextureArray&) = delete;
+};
+
+// Texture setup shared by the textured primitives. A packed diffuse map only selects its layer;
+// otherwise both views are bound (image and sampler) to units 0 and 1 as before. The shaders never sample
+// specularMap, so skipping its binding in the array path changes nothing on screen.
+inline void bindMaterialTextures(Shader& shader, unsigned int diffuseMap, unsigned int specularMap)
+{
+    int layer = MaterialTextureArray::instance().layerOf(diffuseMap);
+    shader.setBool("useTextureArray", layer >= 0);
+    if (layer >= 0)
+    {
+        shader.setFloat("diffuseLayer", (float)layer);
+        return;
+    }
+
+    TextureCache::instance().bind(0, diffuseMap);
+    TextureCache::instance().bind(1, specularMap);
+}
+
+#endif /* textureArray_h */
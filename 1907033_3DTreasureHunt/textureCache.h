@@ -0,0 +1,743 @@
+//
+//  textureCache.h
+
+//
+
+#ifndef textureCache_h
+#define textureCache_h
+
+#include <glad/glad.h>
+#include <string>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include "stb_image.h"
+#include "textureLoader.h"
+#include "glHandle.h"
+#include "samplerCache.h"
+
+// key of a texture view: the image file plus the sampler state it is sampled with
+struct TextureKey
+{
+    std::string path;
+    GLint wrapS;
+    GLint wrapT;
+    GLint minFilter;
+    GLint magFilter;
+
+    bool operator==(const TextureKey& other) const
+    {
+        return path == other.path && wrapS == other.wrapS && wrapT == other.wrapT
+            && minFilter == other.minFilter && magFilter == other.magFilter;
+    }
+};
+
+struct TextureKeyHash
+{
+    size_t operator()(const TextureKey& key) const
+    {
+        size_t h = std::hash<std::string>()(key.path);
+        GLint params[] = { key.wrapS, key.wrapT, key.minFilter, key.magFilter };
+        for (GLint p : params)
+            h ^= std::hash<GLint>()(p) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+// one GL texture object (one image, no sampler state) owned by the cache; deleted when the last handle goes away
+struct TextureEntry
+{
+    std::string path;
+    GLTexture id;           // deleted with the last handle
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    size_t bytes = 0;       // estimated GPU bytes including the mip chain
+    size_t savedBytes = 0;  // difference to the same texture uncompressed
+    bool pinned = false;    // referenced by a view id handed out through loadTexture(), never collected
+    bool ready = false;     // false until the decoded image has been uploaded on the GL thread
+
+    // residency
+    std::vector<size_t> levelBytes;         // GPU bytes of each uploaded mip level
+    std::vector<size_t> levelSavedBytes;    // of each level, bytes saved by block compression
+    int baseLevel = 0;                      // levels below this were dropped to stay under budget
+    bool evicted = false;                   // storage released, only the placeholder texel is left
+    bool loading = false;                   // a decode/upload for this texture is in flight
+    unsigned long long lastUsedFrame = 0;
+    unsigned int roomMask = 0;              // bit r is set when room r uses the texture
+
+    // streaming
+    bool streaming = false;                 // coarse levels resident, finer ones still on their way
+    unsigned int generation = 0;            // bumped whenever the storage is replaced; stale stream steps are dropped
+};
+
+// shared, reference-counted handle to a cached texture
+typedef std::shared_ptr<TextureEntry> TextureHandle;
+
+// what a view id returned by loadTexture() stands for: an image sampled through a sampler object
+struct TextureView
+{
+    unsigned int viewId = 0;
+    TextureKey key;
+    TextureHandle image;
+    GLuint sampler = 0;
+};
+
+class TextureCache
+{
+public:
+    struct Stats
+    {
+        unsigned long long hits = 0;
+        unsigned long long misses = 0;
+        size_t residentBytes = 0;
+        size_t savedBytes = 0;      // VRAM not spent thanks to block-compressed containers
+        size_t textureCount = 0;
+        size_t viewCount = 0;
+        size_t samplerCount = 0;
+    };
+
+    static TextureCache& instance()
+    {
+        static TextureCache cache;
+        return cache;
+    }
+
+    // Returns the image stored in a file without waiting for it. On the first request the GL
+    // name is created right away and the file is queued for decoding, so the handle works
+    // like a future: its id can be stored immediately and the image appears once
+    // pumpUploads() has run. Must be called on the GL thread.
+    TextureHandle acquireAsync(const std::string& path)
+    {
+        auto it = entries.find(path);
+        if (it != entries.end())
+        {
+            ++stats.hits;
+            return it->second;
+        }
+
+        ++stats.misses;
+        if (!blockFormatsQueried)
+        {
+            loader.setSupportedBlockFormats(queryBlockFormatSupport());
+            blockFormatsQueried = true;
+        }
+        TextureHandle handle = std::make_shared<TextureEntry>();
+        handle->path = path;
+        handle->id = GLTexture::create(GL_HERE);
+        glBindTexture(GL_TEXTURE_2D, handle->id);
+
+        // wrap and filter state lives in sampler objects (see acquireView), not in the texture
+        specifyPlaceholder();
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        if (loader.idle())
+            batchStart = std::chrono::high_resolution_clock::now();
+        handle->loading = true;
+        handle->lastUsedFrame = frame;
+        loader.request(path, handle);
+        entries.emplace(path, handle);
+        return handle;
+    }
+
+    // same as acquireAsync() but blocks until the image is uploaded
+    TextureHandle acquire(const std::string& path)
+    {
+        TextureHandle handle = acquireAsync(path);
+        wait(handle);
+        return handle;
+    }
+
+    // View id for callers that keep plain unsigned ints: the image of `path` sampled with the
+    // given state. Views of the same file share one texture object and views with the same
+    // state share one sampler object. The id is valid immediately (the image arrives
+    // asynchronously), is not a GL name, and must be bound through bind(). 0 means no texture.
+    unsigned int acquireView(const char* path, GLint wrapS, GLint wrapT, GLint minFilter, GLint magFilter)
+    {
+        TextureKey key = { path, wrapS, wrapT, minFilter, magFilter };
+        auto it = viewIds.find(key);
+        if (it != viewIds.end())
+        {
+            ++stats.hits;
+            return it->second;
+        }
+
+        TextureView view;
+        view.viewId = (unsigned int)views.size() + 1;
+        view.key = key;
+        view.image = acquireAsync(key.path);
+        view.image->pinned = true;
+        SamplerKey samplerKey = { wrapS, wrapT, minFilter, magFilter, samplers.getDefaultAnisotropy() };
+        view.sampler = samplers.acquire(samplerKey);
+        views.push_back(view);
+        viewIds.emplace(key, view.viewId);
+        return view.viewId;
+    }
+
+    // binds a view's image and sampler object to texture unit GL_TEXTURE0 + unit
+    void bind(unsigned int unit, unsigned int viewId)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        if (viewId == 0 || viewId > views.size())
+        {
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glBindSampler(unit, 0);
+            return;
+        }
+        const TextureView& view = views[viewId - 1];
+        markUsed(view.image);
+        glBindTexture(GL_TEXTURE_2D, view.image->id);
+        glBindSampler(unit, view.sampler);
+    }
+
+    // image behind a view id, or an empty handle for an unknown id
+    TextureHandle imageOf(unsigned int viewId) const
+    {
+        if (viewId == 0 || viewId > views.size())
+            return TextureHandle();
+        return views[viewId - 1].image;
+    }
+
+    SamplerCache& samplerCache()
+    {
+        return samplers;
+    }
+
+    // Streaming mode for baked containers: a texture becomes ready as soon as its levels up to
+    // firstSize texels on the longer side are uploaded, which takes well under a millisecond
+    // whatever the source size. The finer levels follow one per step inside the per-frame
+    // upload budget, each lowering GL_TEXTURE_BASE_LEVEL as it arrives. Plain image files
+    // still need their full decode; bake them with --bake-textures to stream them.
+    void setStreaming(bool on, int firstSize = 64)
+    {
+        streamingEnabled = on;
+        streamFirstSize = firstSize;
+        loader.setWarmContainers(on);
+    }
+
+    // uploads whatever the decode workers have finished; call once per frame on the GL thread.
+    // With a budget the uploads stop after about budgetMs and the rest waits for the next frame;
+    // time left over goes to streaming finer levels. Without a budget (wait(), finishPending())
+    // only first levels are uploaded, so blocking calls never wait for full resolution.
+    int pumpUploads(double budgetMs = -1.0)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        int handled = loader.pumpUploads([this](DecodedImage& image) { upload(image); }, budgetMs);
+        if (budgetMs >= 0.0)
+            pumpStreams(budgetMs, start);
+        return handled;
+    }
+
+    // textures still missing some of their finer levels
+    size_t streamingCount() const
+    {
+        return streams.size();
+    }
+
+    // blocks (pumping uploads) until one texture is ready
+    void wait(const TextureHandle& handle)
+    {
+        while (!handle->ready)
+        {
+            if (pumpUploads() == 0)
+            {
+                if (loader.idle())
+                    break;
+                loader.waitForDecoded();
+            }
+        }
+    }
+
+    // blocks (pumping uploads) until every queued texture is ready
+    void finishPending()
+    {
+        if (loader.idle())
+            return;
+        while (!loader.idle())
+        {
+            if (pumpUploads() == 0)
+                loader.waitForDecoded();
+        }
+        pumpUploads();
+
+        double wallMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - batchStart).count();
+        std::cout << "Textures ready after " << wallMs << " ms (decode " << batchDecodeMs
+            << " ms, upload " << batchUploadMs << " ms if done serially)" << std::endl;
+        batchDecodeMs = 0.0;
+        batchUploadMs = 0.0;
+    }
+
+    // drops every unpinned texture no one holds a handle to any more
+    void collectGarbage()
+    {
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (!it->second->pinned && it->second.use_count() == 1)
+            {
+                stats.residentBytes -= it->second->bytes;
+                stats.savedBytes -= it->second->savedBytes;
+                it = entries.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    // releases all textures; must run while the GL context is still current
+    void clear()
+    {
+        loader.shutdown();
+        streams.clear();
+        viewIds.clear();
+        views.clear();
+        entries.clear();
+        samplers.clear();
+        stats.residentBytes = 0;
+        stats.savedBytes = 0;
+    }
+
+    // ---- residency ------------------------------------------------------------------
+
+    // resident bytes above which least-recently-used textures are trimmed; 0 means unlimited
+    void setBudget(size_t bytes)
+    {
+        budgetBytes = bytes;
+    }
+
+    // advances the frame clock behind the LRU order and trims to the budget; once per frame
+    void beginFrame()
+    {
+        ++frame;
+        enforceBudget();
+    }
+
+    // records that a texture is about to be sampled; an evicted one is loaded again (it
+    // shows the placeholder until then) and a demoted one gets its full mip chain back.
+    // bind() calls this itself.
+    void markUsed(const TextureHandle& handle)
+    {
+        handle->lastUsedFrame = frame;
+        if (handle->loading)
+            return;
+        if (handle->evicted || (handle->baseLevel > 0 && !handle->streaming))
+            reload(handle);
+    }
+
+    void assignRoom(const TextureHandle& handle, int room)
+    {
+        handle->roomMask |= 1u << room;
+    }
+
+    // gives every texture that belongs to no room yet to this one
+    void assignUnassigned(int room)
+    {
+        for (auto& entry : entries)
+            if (entry.second->roomMask == 0)
+                assignRoom(entry.second, room);
+    }
+
+    // Room change: textures that only other rooms use are released right away instead of
+    // waiting for the budget, and the new room's textures that were trimmed come back.
+    void enterRoom(int room)
+    {
+        size_t before = stats.residentBytes;
+        int released = 0, restored = 0;
+        for (auto& entry : entries)
+        {
+            const TextureHandle& handle = entry.second;
+            if (handle->roomMask == 0 || handle->loading)
+                continue;
+            if (handle->roomMask & (1u << room))
+            {
+                if (handle->evicted || (handle->baseLevel > 0 && !handle->streaming))
+                {
+                    reload(handle);
+                    ++restored;
+                }
+            }
+            else if (!handle->evicted)
+            {
+                evict(*handle);
+                ++released;
+            }
+        }
+        std::cout << "Entered room " << room << ": released " << released << " textures ("
+            << (before - stats.residentBytes) / 1024 << " KB), reloading " << restored << std::endl;
+    }
+
+    // debug listing of every cached texture, largest first
+    void dumpResident() const
+    {
+        std::vector<TextureHandle> sorted;
+        for (const auto& entry : entries)
+            sorted.push_back(entry.second);
+        std::sort(sorted.begin(), sorted.end(),
+            [](const TextureHandle& a, const TextureHandle& b) { return a->bytes > b->bytes; });
+
+        std::cout << "Resident textures: " << stats.residentBytes / 1024 << " KB";
+        if (budgetBytes != 0)
+            std::cout << " of " << budgetBytes / 1024 << " KB budget";
+        std::cout << ", frame " << frame << std::endl;
+        for (const TextureHandle& handle : sorted)
+        {
+            std::cout << "  #" << handle->id << " " << handle->path << " " << handle->width << "x" << handle->height
+                << " base " << handle->baseLevel << ", " << handle->bytes / 1024 << " KB, last used "
+                << handle->lastUsedFrame << ", rooms 0x" << std::hex << handle->roomMask << std::dec
+                << (handle->evicted ? ", evicted" : "") << (handle->loading ? ", loading" : "")
+                << (handle->streaming ? ", streaming" : "") << std::endl;
+        }
+    }
+
+    // every view handed out so far
+    const std::vector<TextureView>& allViews() const
+    {
+        return views;
+    }
+
+    Stats getStats() const
+    {
+        Stats s = stats;
+        s.textureCount = entries.size();
+        s.viewCount = views.size();
+        s.samplerCount = samplers.count();
+        return s;
+    }
+
+    void printStats() const
+    {
+        Stats s = getStats();
+        std::cout << "Texture cache: " << s.textureCount << " textures, " << s.viewCount << " views, "
+            << s.samplerCount << " samplers, "
+            << s.hits << " hits, " << s.misses << " misses, "
+            << s.residentBytes / 1024 << " KB resident, " << s.savedBytes / 1024 << " KB saved by compression" << std::endl;
+    }
+
+private:
+    std::unordered_map<std::string, TextureHandle> entries;              // one texture object per image file
+    std::unordered_map<TextureKey, unsigned int, TextureKeyHash> viewIds;
+    std::vector<TextureView> views;                                         // view id - 1 -> view
+    SamplerCache samplers;
+    Stats stats;
+    TextureLoader loader;
+    std::chrono::high_resolution_clock::time_point batchStart;
+    double batchDecodeMs = 0.0;
+    double batchUploadMs = 0.0;
+    bool blockFormatsQueried = false;
+
+    unsigned long long frame = 0;
+    size_t budgetBytes = 0;
+
+    // finer container levels still to be uploaded for one texture; the next one is baseLevel - 1
+    struct TextureStream
+    {
+        std::weak_ptr<TextureEntry> target;
+        std::shared_ptr<TextureContainer> container;   // keeps the file mapped until the last level is in
+        unsigned int generation;
+        std::chrono::high_resolution_clock::time_point start;
+    };
+    std::deque<TextureStream> streams;
+    bool streamingEnabled = false;
+    int streamFirstSize = 64;
+
+    static const int EVICT_AFTER_FRAMES = 600;     // unused this long: drop the whole texture, not just a mip
+    static const int MIN_DEMOTED_SIZE = 64;        // demotion stops at this many texels on the longer side
+
+    // 1x1 grey level 0 for the bound texture: a complete mip chain on its own, so a texture
+    // without its image (not loaded yet or evicted) samples flat grey instead of black
+    static void specifyPlaceholder()
+    {
+        static const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+    }
+
+    // takes a texture's current storage out of the totals before it is replaced or released;
+    // levels still queued for streaming belonged to that storage and are dropped with it
+    void forgetStorage(TextureEntry& entry)
+    {
+        stats.residentBytes -= entry.bytes;
+        stats.savedBytes -= entry.savedBytes;
+        entry.bytes = 0;
+        entry.savedBytes = 0;
+        entry.id.setBytes(0);
+        entry.streaming = false;
+        ++entry.generation;
+    }
+
+    // queues the texture's file again; upload() restores the full mip chain
+    void reload(const TextureHandle& handle)
+    {
+        if (loader.idle())
+            batchStart = std::chrono::high_resolution_clock::now();
+        handle->loading = true;
+        loader.request(handle->path, handle);
+    }
+
+    // releases every level and leaves the placeholder texel; the GL name stays valid
+    void evict(TextureEntry& entry)
+    {
+        glBindTexture(GL_TEXTURE_2D, entry.id);
+        for (size_t level = 1; level < entry.levelBytes.size(); ++level)
+            glTexImage2D(GL_TEXTURE_2D, (GLint)level, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        specifyPlaceholder();
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        forgetStorage(entry);
+        entry.baseLevel = 0;
+        entry.evicted = true;
+    }
+
+    // drops the largest remaining mip level by raising GL_TEXTURE_BASE_LEVEL and
+    // redefining the old base as empty; false when the texture is already small
+    bool demote(TextureEntry& entry)
+    {
+        int next = entry.baseLevel + 1;
+        if (next >= (int)entry.levelBytes.size())
+            return false;
+        int width = entry.width >> next, height = entry.height >> next;
+        if ((width > height ? width : height) < MIN_DEMOTED_SIZE)
+            return false;
+
+        glBindTexture(GL_TEXTURE_2D, entry.id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, next);
+        glTexImage2D(GL_TEXTURE_2D, entry.baseLevel, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        size_t freed = entry.levelBytes[entry.baseLevel];
+        size_t unsaved = entry.levelSavedBytes[entry.baseLevel];
+        entry.bytes -= freed;
+        entry.savedBytes -= unsaved;
+        entry.id.setBytes(entry.bytes);
+        stats.residentBytes -= freed;
+        stats.savedBytes -= unsaved;
+        entry.baseLevel = next;
+        return true;
+    }
+
+    // trims least-recently-used textures until the resident set fits the budget: long unused
+    // ones are evicted, recently used ones lose mip levels. Textures sampled in the current
+    // or previous frame are never touched.
+    void enforceBudget()
+    {
+        if (budgetBytes == 0 || stats.residentBytes <= budgetBytes)
+            return;
+
+        std::vector<TextureEntry*> candidates;
+        for (auto& entry : entries)
+        {
+            TextureEntry* texture = entry.second.get();
+            if (texture->ready && !texture->evicted && !texture->loading && !texture->streaming && texture->lastUsedFrame + 1 < frame)
+                candidates.push_back(texture);
+        }
+        std::sort(candidates.begin(), candidates.end(),
+            [](const TextureEntry* a, const TextureEntry* b) { return a->lastUsedFrame < b->lastUsedFrame; });
+
+        for (TextureEntry* texture : candidates)
+        {
+            if (stats.residentBytes <= budgetBytes)
+                break;
+            if (frame - texture->lastUsedFrame > EVICT_AFTER_FRAMES)
+                evict(*texture);
+            else
+                while (stats.residentBytes > budgetBytes && demote(*texture)) {}
+        }
+    }
+
+    TextureCache() {}
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // GL-thread half of the pipeline: moves one decoded image into its texture object
+    void upload(DecodedImage& image)
+    {
+        TextureHandle handle = image.target.lock();
+        if (!handle)
+            return; // released before its pixels arrived
+
+        handle->ready = true;
+        handle->loading = false;
+        handle->lastUsedFrame = frame;
+        if (image.container)
+        {
+            uploadContainer(image, handle);
+            return;
+        }
+        if (!image.pixels)
+        {
+            std::cerr << "Failed to load texture at path: " << image.path << std::endl;
+            return;
+        }
+        if (image.skippedFormat != TEXTURE_FORMAT_RAW8)
+            std::cout << "Texture " << image.path << ": " << blockFormatName(image.skippedFormat)
+                << " not supported by this driver, using the original image" << std::endl;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        glBindTexture(GL_TEXTURE_2D, handle->id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        loader.uploadThroughPixelBuffer(image);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+        double uploadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        handle->width = image.width;
+        handle->height = image.height;
+        handle->channels = image.channels;
+        // drivers pad RGB to 4 bytes per texel
+        size_t texelBytes = image.channels == 3 ? 4 : image.channels;
+        forgetStorage(*handle);
+        handle->levelBytes.clear();
+        handle->levelSavedBytes.clear();
+        for (int w = image.width, h = image.height;; w = w > 1 ? w / 2 : 1, h = h > 1 ? h / 2 : 1)
+        {
+            handle->levelBytes.push_back((size_t)w * h * texelBytes);
+            handle->levelSavedBytes.push_back(0);
+            handle->bytes += handle->levelBytes.back();
+            if (w == 1 && h == 1)
+                break;
+        }
+        handle->baseLevel = 0;
+        handle->evicted = false;
+        handle->id.setBytes(handle->bytes);
+        stats.residentBytes += handle->bytes;
+
+        batchDecodeMs += image.decodeMs;
+        batchUploadMs += uploadMs;
+        std::cout << "Texture " << image.path << " (" << image.width << "x" << image.height
+            << "): decode " << image.decodeMs << " ms, upload " << uploadMs << " ms" << std::endl;
+    }
+
+    // uploads the pre-baked levels straight from the mapped container, no decode or glGenerateMipmap.
+    // In streaming mode only the coarse tail goes up now and pumpStreams() adds the rest.
+    void uploadContainer(DecodedImage& image, const TextureHandle& handle)
+    {
+        const TextureContainer& container = *image.container;
+        const TextureContainerHeader& header = container.header();
+        bool compressed = isBlockFormat(header.format);
+        size_t texelBytes = header.channels == 3 ? 4 : header.channels;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        glBindTexture(GL_TEXTURE_2D, handle->id);
+        forgetStorage(*handle);
+        handle->levelBytes.clear();
+        handle->levelSavedBytes.clear();
+        unsigned int firstLevel = 0;
+        for (unsigned int i = 0; i < header.levelCount; ++i)
+        {
+            const TextureContainerLevel& level = container.level(i);
+            size_t uncompressed = (size_t)level.width * level.height * texelBytes;
+            handle->levelBytes.push_back(compressed ? (size_t)level.size : uncompressed);
+            // the 4x4 blocks of the smallest levels can take more than the texels they cover
+            handle->levelSavedBytes.push_back(uncompressed > handle->levelBytes.back() ? uncompressed - handle->levelBytes.back() : 0);
+            if (streamingEnabled && (int)(level.width > level.height ? level.width : level.height) > streamFirstSize)
+                firstLevel = i + 1;
+        }
+        if (firstLevel >= header.levelCount)
+            firstLevel = header.levelCount - 1;
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (unsigned int i = firstLevel; i < header.levelCount; ++i)
+            uploadContainerLevel(container, i, *handle);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, firstLevel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header.levelCount - 1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        double uploadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        handle->width = header.width;
+        handle->height = header.height;
+        handle->channels = header.channels;
+        handle->baseLevel = firstLevel;
+        handle->evicted = false;
+        if (firstLevel > 0)
+        {
+            handle->streaming = true;
+            TextureStream stream = { handle, image.container, handle->generation, start };
+            streams.push_back(stream);
+        }
+
+        batchDecodeMs += image.decodeMs;
+        batchUploadMs += uploadMs;
+        std::cout << "Texture " << image.path << " (" << header.width << "x" << header.height << ", "
+            << header.levelCount << " baked levels): map " << image.decodeMs << " ms, upload " << uploadMs << " ms";
+        if (firstLevel > 0)
+            std::cout << ", streaming from " << container.level(firstLevel).width << "x" << container.level(firstLevel).height;
+        std::cout << std::endl;
+        if (compressed && firstLevel == 0)
+            std::cout << "    " << blockFormatName(header.format) << ": " << handle->bytes / 1024 << " KB instead of "
+                << (handle->bytes + handle->savedBytes) / 1024 << " KB, saved " << handle->savedBytes / 1024 << " KB" << std::endl;
+    }
+
+    // specifies one container level of the bound texture and books its bytes
+    void uploadContainerLevel(const TextureContainer& container, unsigned int i, TextureEntry& entry)
+    {
+        const TextureContainerHeader& header = container.header();
+        const TextureContainerLevel& level = container.level(i);
+
+        GLenum format = GL_RGB;
+        if (header.channels == 1)
+            format = GL_RED;
+        else if (header.channels == 3)
+            format = GL_RGB;
+        else if (header.channels == 4)
+            format = GL_RGBA;
+
+        if (isBlockFormat(header.format))
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, blockFormatInternalFormat(header.format), level.width, level.height,
+                0, (GLsizei)level.size, container.levelData(i));
+        else
+            glTexImage2D(GL_TEXTURE_2D, i, format, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, container.levelData(i));
+
+        size_t saved = entry.levelSavedBytes[i];
+        entry.bytes += entry.levelBytes[i];
+        entry.id.setBytes(entry.bytes);
+        entry.savedBytes += saved;
+        stats.residentBytes += entry.levelBytes[i];
+        stats.savedBytes += saved;
+    }
+
+    // Uploads the next finer level of the queued streams until the frame's upload budget is
+    // spent, taking the textures in turn so they all sharpen at the same pace. Only
+    // GL_TEXTURE_BASE_LEVEL moves: GL_TEXTURE_MIN_LOD is sampler state, and the sampler
+    // objects bound by bind() would override a per-texture value anyway.
+    void pumpStreams(double budgetMs, std::chrono::high_resolution_clock::time_point start)
+    {
+        while (!streams.empty())
+        {
+            double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            if (elapsedMs >= budgetMs)
+                break;
+
+            TextureStream stream = streams.front();
+            streams.pop_front();
+            TextureHandle handle = stream.target.lock();
+            if (!handle || !handle->streaming || handle->generation != stream.generation)
+                continue; // released, evicted or reloaded since the stream started
+
+            int level = handle->baseLevel - 1;
+            glBindTexture(GL_TEXTURE_2D, handle->id);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            uploadContainerLevel(*stream.container, level, *handle);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            handle->baseLevel = level;
+
+            if (level > 0)
+            {
+                streams.push_back(stream);
+                continue;
+            }
+            handle->streaming = false;
+            double streamMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - stream.start).count();
+            std::cout << "Texture " << handle->path << " streamed to full resolution after " << streamMs << " ms" << std::endl;
+        }
+    }
+};
+
+#endif /* textureCache_h */
@@ -0,0 +1,398 @@
+//
+//  textureCompression.h
+//
+
+//
+
+#ifndef textureCompression_h
+#define textureCompression_h
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// glad is generated for core 3.3, which has neither of these extensions' enums
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+// block formats a texture container can hold, next to TEXTURE_FORMAT_RAW8 (0)
+enum TextureBlockFormat
+{
+    TEXTURE_FORMAT_BC1 = 1,     // RGB, 8 bytes per 4x4 block
+    TEXTURE_FORMAT_BC3 = 2,     // RGBA, 16 bytes per block (BC1 colour + interpolated alpha)
+    TEXTURE_FORMAT_BC7 = 3      // RGBA, 16 bytes per block, encoded with mode 6 only
+};
+
+// what the offline baker should store
+enum TextureCompression
+{
+    TEXTURE_COMPRESSION_NONE,   // raw 8-bit levels
+    TEXTURE_COMPRESSION_S3TC,   // BC1 for RGB, BC3 for RGBA
+    TEXTURE_COMPRESSION_BPTC    // BC7 for RGB and RGBA
+};
+
+inline bool isBlockFormat(uint32_t format)
+{
+    return format == TEXTURE_FORMAT_BC1 || format == TEXTURE_FORMAT_BC3 || format == TEXTURE_FORMAT_BC7;
+}
+
+inline const char* blockFormatName(uint32_t format)
+{
+    switch (format)
+    {
+    case TEXTURE_FORMAT_BC1: return "BC1";
+    case TEXTURE_FORMAT_BC3: return "BC3";
+    case TEXTURE_FORMAT_BC7: return "BC7";
+    default: return "RAW";
+    }
+}
+
+inline GLenum blockFormatInternalFormat(uint32_t format)
+{
+    switch (format)
+    {
+    case TEXTURE_FORMAT_BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case TEXTURE_FORMAT_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case TEXTURE_FORMAT_BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    default: return 0;
+    }
+}
+
+inline size_t blockFormatLevelSize(uint32_t format, int width, int height)
+{
+    size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+    return blocks * (format == TEXTURE_FORMAT_BC1 ? 8 : 16);
+}
+
+// Bit mask (1 << format) of the block formats the current context can sample.
+// Needs a current context; Mesa llvmpipe for instance may lack S3TC.
+inline unsigned int queryBlockFormatSupport()
+{
+    bool s3tc = false, bptc = false;
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (!name)
+            continue;
+        if (strcmp(name, "GL_EXT_texture_compression_s3tc") == 0)
+            s3tc = true;
+        else if (strcmp(name, "GL_ARB_texture_compression_bptc") == 0)
+            bptc = true;
+    }
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major > 4 || (major == 4 && minor >= 2))
+        bptc = true; // core since 4.2
+
+    unsigned int mask = 0;
+    if (s3tc)
+        mask |= (1u << TEXTURE_FORMAT_BC1) | (1u << TEXTURE_FORMAT_BC3);
+    if (bptc)
+        mask |= (1u << TEXTURE_FORMAT_BC7);
+    return mask;
+}
+
+// ---------------------------------------------------------------------------
+// encoders, used by the offline baker. All take one 4x4 block of RGBA8 texels.
+
+// end points of the principal axis through a block's colours (first `dims` channels)
+inline void blockPrincipalEndpoints(const unsigned char rgba[16][4], int dims, float lo[4], float hi[4])
+{
+    float mean[4] = { 0, 0, 0, 0 };
+    for (int i = 0; i < 16; ++i)
+        for (int k = 0; k < dims; ++k)
+            mean[k] += rgba[i][k] / 16.0f;
+
+    float cov[4][4] = {};
+    for (int i = 0; i < 16; ++i)
+        for (int a = 0; a < dims; ++a)
+            for (int b = 0; b < dims; ++b)
+                cov[a][b] += (rgba[i][a] - mean[a]) * (rgba[i][b] - mean[b]);
+
+    // power iteration for the dominant eigenvector
+    float axis[4] = { 1, 1, 1, 1 };
+    for (int iter = 0; iter < 8; ++iter)
+    {
+        float next[4] = { 0, 0, 0, 0 };
+        float len = 0.0f;
+        for (int a = 0; a < dims; ++a)
+        {
+            for (int b = 0; b < dims; ++b)
+                next[a] += cov[a][b] * axis[b];
+            len += next[a] * next[a];
+        }
+        if (len < 1e-12f)
+            break;
+        len = sqrtf(len);
+        for (int a = 0; a < dims; ++a)
+            axis[a] = next[a] / len;
+    }
+
+    float minT = 1e30f, maxT = -1e30f;
+    for (int i = 0; i < 16; ++i)
+    {
+        float t = 0.0f;
+        for (int k = 0; k < dims; ++k)
+            t += (rgba[i][k] - mean[k]) * axis[k];
+        minT = t < minT ? t : minT;
+        maxT = t > maxT ? t : maxT;
+    }
+    for (int k = 0; k < 4; ++k)
+    {
+        float m = k < dims ? mean[k] : 255.0f;
+        float a = k < dims ? axis[k] : 0.0f;
+        lo[k] = fminf(fmaxf(m + a * minT, 0.0f), 255.0f);
+        hi[k] = fminf(fmaxf(m + a * maxT, 0.0f), 255.0f);
+    }
+}
+
+inline uint16_t packRgb565(const float c[4])
+{
+    int r = (int)(c[0] * 31.0f / 255.0f + 0.5f);
+    int g = (int)(c[1] * 63.0f / 255.0f + 0.5f);
+    int b = (int)(c[2] * 31.0f / 255.0f + 0.5f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+inline void unpackRgb565(uint16_t c, int out[3])
+{
+    int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+}
+
+// BC1 colour block in four-colour mode (8 bytes)
+inline void encodeBC1Block(const unsigned char rgba[16][4], unsigned char* out)
+{
+    float lo[4], hi[4];
+    blockPrincipalEndpoints(rgba, 3, lo, hi);
+    uint16_t c0 = packRgb565(hi), c1 = packRgb565(lo);
+    if (c0 < c1)
+    {
+        uint16_t t = c0; c0 = c1; c1 = t;
+    }
+
+    uint32_t indices = 0;
+    if (c0 != c1)
+    {
+        int palette[4][3];
+        unpackRgb565(c0, palette[0]);
+        unpackRgb565(c1, palette[1]);
+        for (int k = 0; k < 3; ++k)
+        {
+            palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;
+            palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;
+        }
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0, bestError = 1 << 30;
+            for (int p = 0; p < 4; ++p)
+            {
+                int error = 0;
+                for (int k = 0; k < 3; ++k)
+                {
+                    int d = rgba[i][k] - palette[p][k];
+                    error += d * d;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            indices |= (uint32_t)best << (2 * i);
+        }
+    }
+
+    out[0] = c0 & 0xFF; out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF; out[3] = c1 >> 8;
+    for (int i = 0; i < 4; ++i)
+        out[4 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+// BC4-style alpha block of BC3 in eight-value mode (8 bytes)
+inline void encodeBC3AlphaBlock(const unsigned char rgba[16][4], unsigned char* out)
+{
+    int a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; ++i)
+    {
+        a0 = rgba[i][3] > a0 ? rgba[i][3] : a0;
+        a1 = rgba[i][3] < a1 ? rgba[i][3] : a1;
+    }
+
+    uint64_t indices = 0;
+    if (a0 != a1)
+    {
+        int palette[8] = { a0, a1 };
+        for (int p = 2; p < 8; ++p)
+            palette[p] = ((8 - p) * a0 + (p - 1) * a1) / 7;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0, bestError = 1 << 30;
+            for (int p = 0; p < 8; ++p)
+            {
+                int d = rgba[i][3] - palette[p];
+                if (d * d < bestError)
+                {
+                    bestError = d * d;
+                    best = p;
+                }
+            }
+            indices |= (uint64_t)best << (3 * i);
+        }
+    }
+
+    out[0] = (unsigned char)a0;
+    out[1] = (unsigned char)a1;
+    for (int i = 0; i < 6; ++i)
+        out[2 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+inline void encodeBC3Block(const unsigned char rgba[16][4], unsigned char* out)
+{
+    encodeBC3AlphaBlock(rgba, out);
+    encodeBC1Block(rgba, out + 8);
+}
+
+// BC7 mode 6: one subset, RGBA 7.7.7.7 end points with a p-bit each, 4-bit indices (16 bytes)
+inline void encodeBC7Block(const unsigned char rgba[16][4], unsigned char* out)
+{
+    static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    float lo[4], hi[4];
+    blockPrincipalEndpoints(rgba, 4, lo, hi);
+
+    // quantise each end point to 7 bits per channel, picking the p-bit with the smaller error
+    int ends[2][4], endBits[2][4], pbits[2];
+    const float* source[2] = { lo, hi };
+    for (int e = 0; e < 2; ++e)
+    {
+        int bestError = 1 << 30;
+        for (int p = 0; p < 2; ++p)
+        {
+            int error = 0, bits[4], values[4];
+            for (int k = 0; k < 4; ++k)
+            {
+                int q = (int)((source[e][k] - p) / 2.0f + 0.5f);
+                q = q < 0 ? 0 : (q > 127 ? 127 : q);
+                bits[k] = q;
+                values[k] = (q << 1) | p;
+                int d = values[k] - (int)(source[e][k] + 0.5f);
+                error += d * d;
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                pbits[e] = p;
+                memcpy(endBits[e], bits, sizeof(bits));
+                memcpy(ends[e], values, sizeof(values));
+            }
+        }
+    }
+
+    int indices[16];
+    for (int i = 0; i < 16; ++i)
+    {
+        int best = 0, bestError = 1 << 30;
+        for (int w = 0; w < 16; ++w)
+        {
+            int error = 0;
+            for (int k = 0; k < 4; ++k)
+            {
+                int v = ((64 - weights[w]) * ends[0][k] + weights[w] * ends[1][k] + 32) >> 6;
+                int d = rgba[i][k] - v;
+                error += d * d;
+            }
+            if (error < bestError)
+            {
+                bestError = error;
+                best = w;
+            }
+        }
+        indices[i] = best;
+    }
+
+    // the anchor index is stored with 3 bits, so its top bit must be zero
+    if (indices[0] & 8)
+    {
+        for (int k = 0; k < 4; ++k)
+        {
+            int t = endBits[0][k]; endBits[0][k] = endBits[1][k]; endBits[1][k] = t;
+        }
+        int t = pbits[0]; pbits[0] = pbits[1]; pbits[1] = t;
+        for (int i = 0; i < 16; ++i)
+            indices[i] = 15 - indices[i];
+    }
+
+    memset(out, 0, 16);
+    int bit = 0;
+    auto put = [&](uint32_t value, int count)
+    {
+        for (int i = 0; i < count; ++i, ++bit)
+            if (value & (1u << i))
+                out[bit >> 3] |= (unsigned char)(1 << (bit & 7));
+    };
+    put(1u << 6, 7); // mode 6
+    for (int k = 0; k < 4; ++k)
+    {
+        put(endBits[0][k], 7);
+        put(endBits[1][k], 7);
+    }
+    put(pbits[0], 1);
+    put(pbits[1], 1);
+    put(indices[0], 3);
+    for (int i = 1; i < 16; ++i)
+        put(indices[i], 4);
+}
+
+// compresses a tightly packed 8-bit image (1-4 channels) block by block; edge blocks repeat the last row/column
+inline std::vector<unsigned char> compressImageBlocks(const unsigned char* pixels, int width, int height, int channels, uint32_t format)
+{
+    std::vector<unsigned char> out(blockFormatLevelSize(format, width, height));
+    size_t blockBytes = format == TEXTURE_FORMAT_BC1 ? 8 : 16;
+    unsigned char* dst = out.data();
+
+    for (int by = 0; by < height; by += 4)
+    {
+        for (int bx = 0; bx < width; bx += 4)
+        {
+            unsigned char block[16][4];
+            for (int i = 0; i < 16; ++i)
+            {
+                int x = bx + (i & 3), y = by + (i >> 2);
+                x = x < width ? x : width - 1;
+                y = y < height ? y : height - 1;
+                const unsigned char* texel = pixels + ((size_t)y * width + x) * channels;
+                block[i][0] = texel[0];
+                block[i][1] = channels >= 3 ? texel[1] : texel[0];
+                block[i][2] = channels >= 3 ? texel[2] : texel[0];
+                block[i][3] = channels == 4 ? texel[3] : (channels == 2 ? texel[1] : 255);
+            }
+
+            if (format == TEXTURE_FORMAT_BC1)
+                encodeBC1Block(block, dst);
+            else if (format == TEXTURE_FORMAT_BC3)
+                encodeBC3Block(block, dst);
+            else
+                encodeBC7Block(block, dst);
+            dst += blockBytes;
+        }
+    }
+    return out;
+}
+
+#endif /* textureCompression_h */
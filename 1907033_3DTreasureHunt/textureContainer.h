@@ -0,0 +1,316 @@
+//
+//  textureContainer.h
+//
+
+//
+
+#ifndef textureContainer_h
+#define textureContainer_h
+
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include "mappedFile.h"
+#include "textureCompression.h"
+#include "stb_image.h"
+
+// Pre-baked texture container (.thtx). Layout, all little endian:
+//   TextureContainerHeader
+//   TextureContainerLevel[levelCount]      level 0 is the full-size image
+//   level data, every level 4-byte aligned, offsets counted from the start of the file
+// Rows are stored bottom-up, i.e. already flipped the way stbi_set_flip_vertically_on_load does.
+
+const uint32_t TEXTURE_CONTAINER_MAGIC = 0x58544854; // "THTX"
+const uint32_t TEXTURE_CONTAINER_VERSION = 1;
+
+enum TextureContainerFormat
+{
+    TEXTURE_FORMAT_RAW8 = 0     // 8 bits per channel, tightly packed rows; block formats are in textureCompression.h
+};
+
+struct TextureContainerHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t format;
+    uint32_t levelCount;
+    uint32_t reserved;
+};
+
+struct TextureContainerLevel
+{
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// the container that shadows an image file; "vinci.jpg" is baked to "vinci.jpg.thtx"
+inline std::string textureContainerPath(const std::string& imagePath)
+{
+    return imagePath + ".thtx";
+}
+
+// validated read-only view of a mapped container
+class TextureContainer
+{
+public:
+    bool open(const std::string& path)
+    {
+        if (!file.open(path))
+            return false;
+        if (!validate())
+        {
+            std::cerr << "Ignoring invalid texture container: " << path << std::endl;
+            file.close();
+            return false;
+        }
+        return true;
+    }
+
+    bool isOpen() const { return file.isOpen(); }
+
+    const TextureContainerHeader& header() const
+    {
+        return *reinterpret_cast<const TextureContainerHeader*>(file.data());
+    }
+
+    const TextureContainerLevel& level(unsigned int i) const
+    {
+        return reinterpret_cast<const TextureContainerLevel*>(file.data() + sizeof(TextureContainerHeader))[i];
+    }
+
+    const unsigned char* levelData(unsigned int i) const
+    {
+        return file.data() + level(i).offset;
+    }
+
+private:
+    MappedFile file;
+
+    bool validate() const
+    {
+        if (file.size() < sizeof(TextureContainerHeader))
+            return false;
+        const TextureContainerHeader& h = header();
+        if (h.magic != TEXTURE_CONTAINER_MAGIC || h.version != TEXTURE_CONTAINER_VERSION)
+            return false;
+        if (h.levelCount == 0 || h.levelCount > 32 || h.channels == 0 || h.channels > 4)
+            return false;
+        if (file.size() < sizeof(TextureContainerHeader) + h.levelCount * sizeof(TextureContainerLevel))
+            return false;
+        for (unsigned int i = 0; i < h.levelCount; ++i)
+        {
+            const TextureContainerLevel& l = level(i);
+            if (l.offset + l.size > file.size())
+                return false;
+        }
+        return true;
+    }
+};
+
+// 8-bit image in memory, used while baking
+struct MipImage
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<unsigned char> pixels;
+};
+
+// Halves an image with a box filter over each destination texel's exact footprint
+// (so odd sizes are handled without dropping rows), averaging colour in linear light.
+inline MipImage downsampleMip(const MipImage& src)
+{
+    static float toLinear[256];
+    static bool tableReady = false;
+    if (!tableReady)
+    {
+        for (int i = 0; i < 256; ++i)
+            toLinear[i] = powf(i / 255.0f, 2.2f);
+        tableReady = true;
+    }
+
+    MipImage dst;
+    dst.width = src.width > 1 ? src.width / 2 : 1;
+    dst.height = src.height > 1 ? src.height / 2 : 1;
+    dst.channels = src.channels;
+    dst.pixels.resize((size_t)dst.width * dst.height * dst.channels);
+
+    int c = src.channels;
+    bool gammaChannel[4];
+    for (int k = 0; k < 4; ++k)
+        gammaChannel[k] = (c >= 3 && k < 3); // colour of RGB(A) images; alpha and single-channel data stay linear
+
+    // filter weights of one axis: source range [i*scale, (i+1)*scale) for destination texel i
+    auto buildTaps = [](int srcSize, int dstSize, std::vector<int>& first, std::vector<std::vector<float>>& weights)
+    {
+        float scale = (float)srcSize / dstSize;
+        first.resize(dstSize);
+        weights.resize(dstSize);
+        for (int i = 0; i < dstSize; ++i)
+        {
+            float a = i * scale, b = (i + 1) * scale;
+            int s0 = (int)floorf(a), s1 = (int)ceilf(b);
+            if (s1 > srcSize)
+                s1 = srcSize;
+            first[i] = s0;
+            weights[i].clear();
+            for (int s = s0; s < s1; ++s)
+            {
+                float lo = a > s ? a : (float)s;
+                float hi = b < s + 1 ? b : (float)(s + 1);
+                weights[i].push_back((hi - lo) / scale);
+            }
+        }
+    };
+
+    std::vector<int> firstX, firstY;
+    std::vector<std::vector<float>> weightX, weightY;
+    buildTaps(src.width, dst.width, firstX, weightX);
+    buildTaps(src.height, dst.height, firstY, weightY);
+
+    // horizontal pass into linear floats
+    std::vector<float> rows((size_t)dst.width * src.height * c);
+    for (int y = 0; y < src.height; ++y)
+    {
+        const unsigned char* in = &src.pixels[(size_t)y * src.width * c];
+        float* out = &rows[(size_t)y * dst.width * c];
+        for (int x = 0; x < dst.width; ++x)
+        {
+            for (int k = 0; k < c; ++k)
+            {
+                float sum = 0.0f;
+                for (size_t t = 0; t < weightX[x].size(); ++t)
+                {
+                    unsigned char v = in[(firstX[x] + t) * c + k];
+                    sum += weightX[x][t] * (gammaChannel[k] ? toLinear[v] : v / 255.0f);
+                }
+                out[x * c + k] = sum;
+            }
+        }
+    }
+
+    // vertical pass and back to 8 bits
+    for (int y = 0; y < dst.height; ++y)
+    {
+        for (int x = 0; x < dst.width; ++x)
+        {
+            for (int k = 0; k < c; ++k)
+            {
+                float sum = 0.0f;
+                for (size_t t = 0; t < weightY[y].size(); ++t)
+                    sum += weightY[y][t] * rows[((size_t)(firstY[y] + t) * dst.width + x) * c + k];
+                float v = gammaChannel[k] ? powf(sum, 1.0f / 2.2f) : sum;
+                int q = (int)(v * 255.0f + 0.5f);
+                dst.pixels[((size_t)y * dst.width + x) * c + k] = (unsigned char)(q < 0 ? 0 : (q > 255 ? 255 : q));
+            }
+        }
+    }
+    return dst;
+}
+
+// full mip chain of an image, level 0 first
+inline std::vector<MipImage> buildMipChain(MipImage base)
+{
+    std::vector<MipImage> chain;
+    chain.push_back(std::move(base));
+    while (chain.back().width > 1 || chain.back().height > 1)
+        chain.push_back(downsampleMip(chain.back()));
+    return chain;
+}
+
+// writes the given levels as a container; level payloads are taken verbatim
+inline bool writeTextureContainer(const std::string& containerPath, uint32_t width, uint32_t height, uint32_t channels,
+    uint32_t format, const std::vector<MipImage>& levels, const std::vector<std::vector<unsigned char>>& payloads)
+{
+    FILE* out = fopen(containerPath.c_str(), "wb");
+    if (!out)
+    {
+        std::cerr << "Unable to write texture container: " << containerPath << std::endl;
+        return false;
+    }
+
+    TextureContainerHeader header = { TEXTURE_CONTAINER_MAGIC, TEXTURE_CONTAINER_VERSION, width, height,
+        channels, format, (uint32_t)payloads.size(), 0 };
+
+    std::vector<TextureContainerLevel> table(payloads.size());
+    uint64_t offset = sizeof(header) + table.size() * sizeof(TextureContainerLevel);
+    for (size_t i = 0; i < payloads.size(); ++i)
+    {
+        offset = (offset + 3) & ~(uint64_t)3;
+        table[i].width = levels[i].width;
+        table[i].height = levels[i].height;
+        table[i].offset = offset;
+        table[i].size = payloads[i].size();
+        offset += payloads[i].size();
+    }
+
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(table.data(), sizeof(TextureContainerLevel), table.size(), out);
+    long written = (long)(sizeof(header) + table.size() * sizeof(TextureContainerLevel));
+    for (size_t i = 0; i < payloads.size(); ++i)
+    {
+        static const unsigned char zeros[4] = { 0, 0, 0, 0 };
+        fwrite(zeros, 1, (size_t)(table[i].offset - written), out);
+        fwrite(payloads[i].data(), 1, payloads[i].size(), out);
+        written = (long)(table[i].offset + table[i].size);
+    }
+    bool ok = ferror(out) == 0;
+    fclose(out);
+    return ok;
+}
+
+// offline converter: decodes an image once, flips it, builds every mip level and stores the result,
+// block-compressed if asked to (only RGB and RGBA images are compressed, the rest stay raw)
+inline bool bakeTextureContainer(const std::string& imagePath, const std::string& containerPath,
+    TextureCompression compression = TEXTURE_COMPRESSION_NONE)
+{
+    MipImage base;
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char* data = stbi_load(imagePath.c_str(), &base.width, &base.height, &base.channels, 0);
+    if (!data)
+    {
+        std::cerr << "Failed to load texture at path: " << imagePath << std::endl;
+        return false;
+    }
+    base.pixels.assign(data, data + (size_t)base.width * base.height * base.channels);
+    stbi_image_free(data);
+
+    std::vector<MipImage> levels = buildMipChain(std::move(base));
+    uint32_t format = TEXTURE_FORMAT_RAW8;
+    if (levels[0].channels >= 3 && compression == TEXTURE_COMPRESSION_S3TC)
+        format = levels[0].channels == 4 ? TEXTURE_FORMAT_BC3 : TEXTURE_FORMAT_BC1;
+    else if (levels[0].channels >= 3 && compression == TEXTURE_COMPRESSION_BPTC)
+        format = TEXTURE_FORMAT_BC7;
+
+    std::vector<std::vector<unsigned char>> payloads;
+    size_t rawBytes = 0, storedBytes = 0;
+    for (const MipImage& level : levels)
+    {
+        if (format == TEXTURE_FORMAT_RAW8)
+            payloads.push_back(level.pixels);
+        else
+            payloads.push_back(compressImageBlocks(level.pixels.data(), level.width, level.height, level.channels, format));
+        rawBytes += level.pixels.size();
+        storedBytes += payloads.back().size();
+    }
+
+    if (!writeTextureContainer(containerPath, levels[0].width, levels[0].height, levels[0].channels,
+        format, levels, payloads))
+        return false;
+
+    std::cout << "Baked " << imagePath << " -> " << containerPath << " (" << levels[0].width << "x"
+        << levels[0].height << ", " << levels.size() << " levels, " << blockFormatName(format) << ", "
+        << storedBytes / 1024 << " KB of " << rawBytes / 1024 << " KB)" << std::endl;
+    return true;
+}
+
+#endif /* textureContainer_h */
@@ -0,0 +1,292 @@
+//
+//  textureLoader.h
+
+//
+
+#ifndef textureLoader_h
+#define textureLoader_h
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include "stb_image.h"
+#include "textureContainer.h"
+#include "glHandle.h"
+
+struct TextureEntry;
+
+// pixels decoded by a worker, waiting for the GL thread to upload them
+struct DecodedImage
+{
+    std::string path;
+    std::weak_ptr<TextureEntry> target;  // dropped silently if the texture was released meanwhile
+    unsigned char* pixels = nullptr;
+    std::shared_ptr<TextureContainer> container;  // set instead of pixels when a baked .thtx was found
+    uint32_t skippedFormat = TEXTURE_FORMAT_RAW8;  // block format of a container the GPU could not take
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    double decodeMs = 0.0;
+};
+
+// Decodes image files on a pool of worker threads. Only pumpUploads() touches GL,
+// so it has to be called from the thread that owns the context.
+class TextureLoader
+{
+public:
+    TextureLoader()
+    {
+        // stb_image keeps the flip flag in a global; set it once before any worker starts
+        stbi_set_flip_vertically_on_load(true);
+
+        unsigned int count = std::thread::hardware_concurrency();
+        count = count > 1 ? count - 1 : 1;
+        for (unsigned int i = 0; i < count; ++i)
+            workers.emplace_back(&TextureLoader::workerLoop, this);
+    }
+
+    ~TextureLoader()
+    {
+        shutdown();
+    }
+
+    // bit mask (1 << format) of block formats the context samples; containers in other formats
+    // are skipped in favour of the original image. Set from the GL thread before requesting.
+    void setSupportedBlockFormats(unsigned int mask)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        supportedBlockFormats = mask;
+    }
+
+    // in streaming mode the workers read ahead through the levels of a container after handing
+    // it over, so the GL thread streams the finer levels from the page cache instead of the disk
+    void setWarmContainers(bool on)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        warmContainers = on;
+    }
+
+    // queues a file for decoding; the result is delivered to the callback from pumpUploads()
+    void request(const std::string& path, const std::weak_ptr<TextureEntry>& target)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            DecodedImage job;
+            job.path = path;
+            job.target = target;
+            jobs.push_back(job);
+            ++inFlight;
+        }
+        jobReady.notify_one();
+    }
+
+    // hands what the workers have finished so far to onDecoded (GL thread only), stopping once
+    // budgetMs has been spent so a burst of finished images is spread over several frames;
+    // at least one image is handled per call. Returns the number of images handled.
+    template <typename Callback>
+    int pumpUploads(Callback onDecoded, double budgetMs = -1.0)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        int handled = 0;
+        for (;;)
+        {
+            DecodedImage image;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (done.empty())
+                    break;
+                image = done.front();
+                done.pop_front();
+            }
+
+            onDecoded(image);
+            stbi_image_free(image.pixels);
+            image.pixels = nullptr;
+            ++handled;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --inFlight;
+            }
+
+            double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            if (budgetMs >= 0.0 && elapsedMs >= budgetMs)
+                break;
+        }
+        return handled;
+    }
+
+    // blocks until at least one decoded image is waiting or nothing is left in flight
+    void waitForDecoded()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        decoded.wait(lock, [this] { return !done.empty() || inFlight == 0; });
+    }
+
+    bool idle()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return inFlight == 0;
+    }
+
+    void shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping)
+                return;
+            stopping = true;
+        }
+        jobReady.notify_all();
+        for (std::thread& t : workers)
+            t.join();
+        workers.clear();
+
+        for (DecodedImage& image : done)
+            stbi_image_free(image.pixels);
+        done.clear();
+        jobs.clear();
+        inFlight = 0;
+
+        for (GLBuffer& buffer : pixelBuffers)
+            buffer.reset();
+    }
+
+    // Copies the pixels into a pixel unpack buffer and specifies level 0 of the texture
+    // currently bound to GL_TEXTURE_2D from it. The buffer is filled and read in the same
+    // call, so it is only a staging copy the driver can take asynchronously, not an upload
+    // overlapped with the next one. If the buffer cannot be mapped the pixels are given
+    // to glTexImage2D directly.
+    void uploadThroughPixelBuffer(const DecodedImage& image)
+    {
+        if (!pixelBuffers[0])
+            for (GLBuffer& buffer : pixelBuffers)
+                buffer = GLBuffer::create(GL_HERE);
+
+        GLenum format = GL_RGB;
+        if (image.channels == 1)
+            format = GL_RED;
+        else if (image.channels == 3)
+            format = GL_RGB;
+        else if (image.channels == 4)
+            format = GL_RGBA;
+
+        GLsizeiptr size = (GLsizeiptr)image.width * image.height * image.channels;
+        unsigned int pbo = pixelBuffers[nextPixelBuffer];
+        nextPixelBuffer = (nextPixelBuffer + 1) % PIXEL_BUFFER_COUNT;
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW); // orphan the previous contents
+        pixelBuffers[(nextPixelBuffer + PIXEL_BUFFER_COUNT - 1) % PIXEL_BUFFER_COUNT].setBytes(size);
+        void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        const void* source = (void*)0;      // offset into the pixel buffer
+        if (dst)
+        {
+            memcpy(dst, image.pixels, size);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        else
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            source = image.pixels;
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // rows of RGB/RED images are not 4-byte aligned
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, source);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+private:
+    static const int PIXEL_BUFFER_COUNT = 2;
+
+    std::vector<std::thread> workers;
+    std::deque<DecodedImage> jobs;
+    std::deque<DecodedImage> done;
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    std::condition_variable decoded;
+    int inFlight = 0;
+    bool stopping = false;
+    unsigned int supportedBlockFormats = 0;
+    bool warmContainers = false;
+
+    GLBuffer pixelBuffers[PIXEL_BUFFER_COUNT];
+    int nextPixelBuffer = 0;
+
+    void workerLoop()
+    {
+        for (;;)
+        {
+            DecodedImage job;
+            unsigned int blockFormats;
+            bool warm;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                jobReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping)
+                    return;
+                job = jobs.front();
+                jobs.pop_front();
+                blockFormats = supportedBlockFormats;
+                warm = warmContainers;
+            }
+
+            auto start = std::chrono::high_resolution_clock::now();
+            // a baked container next to the image skips decoding entirely; the original is the fallback
+            std::shared_ptr<TextureContainer> container = std::make_shared<TextureContainer>();
+            if (container->open(textureContainerPath(job.path)) && isBlockFormat(container->header().format)
+                && !(blockFormats & (1u << container->header().format)))
+            {
+                job.skippedFormat = container->header().format;
+                container.reset();
+            }
+            if (container && container->isOpen())
+            {
+                job.container = container;
+                job.width = container->header().width;
+                job.height = container->header().height;
+                job.channels = container->header().channels;
+            }
+            else
+                job.pixels = stbi_load(job.path.c_str(), &job.width, &job.height, &job.channels, 0);
+            job.decodeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (stopping)
+                {
+                    stbi_image_free(job.pixels);
+                    return;
+                }
+                done.push_back(job);
+            }
+            decoded.notify_all();
+
+            if (warm && job.container)
+                touchLevels(*job.container);
+        }
+    }
+
+    // reads one byte per page of every level, finest last, to fault the mapping in
+    static void touchLevels(const TextureContainer& container)
+    {
+        volatile unsigned char sink = 0;
+        for (unsigned int i = container.header().levelCount; i-- > 0;)
+        {
+            const unsigned char* data = container.levelData(i);
+            for (uint64_t offset = 0; offset < container.level(i).size; offset += 4096)
+                sink ^= data[offset];
+        }
+        (void)sink;
+    }
+};
+
+#endif /* textureLoader_h */
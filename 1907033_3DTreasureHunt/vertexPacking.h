@@ -0,0 +1,143 @@
+//
+//  vertexPacking.h
+//
+
+//
+
+#ifndef vertexPacking_h
+#define vertexPacking_h
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+
+// 16-byte vertex, half of the usual 8 floats:
+//   position  3 half floats + 1 half of padding (exact for the 0/1 cube corners, ~1e-3 relative
+//             error elsewhere, and no per-mesh dequantization to pass to the shaders)
+//   normal    octahedral encoding in x and y of a GL_INT_2_10_10_10_REV, w = -1 marks it as such
+//   uv        2 half floats, so tiled coordinates above 1 survive
+// The vertex shaders decode the normal in decodeNormal(); float normals reach them with w = 1.
+struct PackedVertex
+{
+    uint16_t position[4];
+    uint32_t normal;
+    uint16_t texCoords[2];
+};
+
+// IEEE half with round to nearest even; overflow becomes infinity, tiny values flush to zero
+inline uint16_t packHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (((bits >> 23) & 0xFF) == 0xFF)      // inf / nan
+        return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    if (exponent >= 31)
+        return (uint16_t)(sign | 0x7C00);
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return (uint16_t)sign;
+        mantissa |= 0x800000;               // subnormal half
+        int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+            ++half;
+        return (uint16_t)(sign | half);
+    }
+    uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        ++half;                             // may carry into the exponent, which is still correct
+    return (uint16_t)(sign | half);
+}
+
+// unit normal -> octahedral (u, v) in [-1, 1]
+inline void octahedralEncode(float x, float y, float z, float& u, float& v)
+{
+    float length = fabsf(x) + fabsf(y) + fabsf(z);
+    if (length < 1e-20f)
+    {
+        u = 0.0f;
+        v = 0.0f;
+        return;
+    }
+    u = x / length;
+    v = y / length;
+    if (z < 0.0f)
+    {
+        float foldedU = (1.0f - fabsf(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+        float foldedV = (1.0f - fabsf(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+        u = foldedU;
+        v = foldedV;
+    }
+}
+
+inline uint32_t packOctahedralNormal(float x, float y, float z)
+{
+    float u, v;
+    octahedralEncode(x, y, z, u, v);
+    auto snorm10 = [](float f) {
+        float clamped = f < -1.0f ? -1.0f : (f > 1.0f ? 1.0f : f);
+        return (uint32_t)((int)lroundf(clamped * 511.0f) & 0x3FF);
+    };
+    return snorm10(u) | (snorm10(v) << 10) | (0u << 20) | (2u << 30);    // w = -2, read as -1
+}
+
+// Interleaved float vertices (position, normal[, uv]) to packed ones; missing uvs become 0
+inline void packVertices(const float* vertices, size_t vertexCount, int floatsPerVertex, std::vector<PackedVertex>& out)
+{
+    out.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const float* v = vertices + i * floatsPerVertex;
+        PackedVertex& p = out[i];
+        p.position[0] = packHalf(v[0]);
+        p.position[1] = packHalf(v[1]);
+        p.position[2] = packHalf(v[2]);
+        p.position[3] = 0;
+        p.normal = floatsPerVertex >= 6 ? packOctahedralNormal(v[3], v[4], v[5]) : packOctahedralNormal(0.0f, 1.0f, 0.0f);
+        p.texCoords[0] = floatsPerVertex >= 8 ? packHalf(v[6]) : 0;
+        p.texCoords[1] = floatsPerVertex >= 8 ? packHalf(v[7]) : 0;
+    }
+}
+
+// points attributes 0-2 of the bound VAO at packed vertices in the bound GL_ARRAY_BUFFER
+inline void setPackedVertexAttributes()
+{
+    glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoords));
+    glEnableVertexAttribArray(2);
+}
+
+// the same for 8-float vertices
+inline void setFloatVertexAttributes()
+{
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+}
+
+// 32-bit indices to 16-bit ones; only valid for meshes of fewer than 65536 vertices
+inline void narrowIndices(const unsigned int* indices, size_t indexCount, std::vector<uint16_t>& out)
+{
+    out.resize(indexCount);
+    for (size_t i = 0; i < indexCount; ++i)
+        out[i] = (uint16_t)indices[i];
+}
+
+#endif /* vertexPacking_h */
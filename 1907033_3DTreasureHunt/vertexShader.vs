@@ -1,11 +1,31 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// the model matrix and material of the draw, in a slot of the streaming per-draw buffer (drawUniforms.h)
+layout (std140) uniform DrawData
+{
+    mat4 model;
+    mat3 normalMatrix; // inverse transpose of model's upper 3x3, worked out once per draw on the CPU
+    ivec4 material; // x = index into the material table
+} draw;
+
+struct FramePointLight {
+    vec4 position;  // xyz; w = 1 when the light is on
+    vec4 ambient;   // rgb; w = k_c
+    vec4 diffuse;   // rgb; w = k_l
+    vec4 specular;  // rgb; w = k_q
+};
+
+// camera and point lights, written once per frame and shared by every lighting program (frameUniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    FramePointLight lights[2];
+} frame;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = frame.projection * frame.view * draw.model * vec4(aPos, 1.0);
 }
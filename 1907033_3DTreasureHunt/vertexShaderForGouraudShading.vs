@@ -1,12 +1,16 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
+layout (location = 1) in vec4 aNormal;
 
 out vec4 LightingColor;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// the model matrix and material of the draw, in a slot of the streaming per-draw buffer (drawUniforms.h)
+layout (std140) uniform DrawData
+{
+    mat4 model;
+    mat3 normalMatrix; // inverse transpose of model's upper 3x3, worked out once per draw on the CPU
+    ivec4 material; // x = index into the material table
+} draw;
 
 struct Material {
     vec3 ambient;
@@ -28,31 +32,96 @@ struct PointLight {
 };
 
 
-#define NR_POINT_LIGHTS 4
+#define NR_POINT_LIGHTS 2
+
+struct FramePointLight {
+    vec4 position;  // xyz; w = 1 when the light is on
+    vec4 ambient;   // rgb; w = k_c
+    vec4 diffuse;   // rgb; w = k_l
+    vec4 specular;  // rgb; w = k_q
+};
 
-uniform vec3 viewPos;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform Material material;
+// camera and point lights, written once per frame and shared by every lighting program (frameUniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    FramePointLight lights[2];
+} frame;
+struct MaterialData {
+    vec4 ambient;   // rgb; w = shininess
+    vec4 diffuse;
+    vec4 specular;
+    vec4 emissive;
+};
+
+// every registered material, written once (materialTable.h)
+layout (std140) uniform MaterialTable
+{
+    MaterialData materials[256];
+};
+Material material; // set from drawMaterial() first thing in main()
 
 // function prototypes
 vec3 CalcPointLight(Material material, PointLight light, vec3 N, vec3 Pos, vec3 V);
 
+// point light i of the frame block in this shader's PointLight form
+PointLight pointLight(int i)
+{
+    FramePointLight l = frame.lights[i];
+    PointLight light;
+    light.position = l.position.xyz;
+    light.k_c = l.ambient.w;
+    light.k_l = l.diffuse.w;
+    light.k_q = l.specular.w;
+    light.ambient = l.ambient.rgb;
+    light.diffuse = l.diffuse.rgb;
+    light.specular = l.specular.rgb;
+    return light;
+}
+
+// Float normals arrive with w = 1. Packed vertices (vertexPacking.h) carry an octahedral
+// encoding in xy and w = -1.
+vec3 decodeNormal(vec4 n)
+{
+    if (n.w >= 0.0)
+        return n.xyz;
+    vec3 v = vec3(n.xy, 1.0 - abs(n.x) - abs(n.y));
+    if (v.z < 0.0)
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
+
+// this draw's entry of the material table in this shader's Material form
+Material drawMaterial()
+{
+    MaterialData m = materials[draw.material.x];
+    Material material;
+    material.ambient = m.ambient.rgb;
+    material.diffuse = m.diffuse.rgb;
+    material.specular = m.specular.rgb;
+    material.shininess = m.ambient.w;
+    return material;
+}
+
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    material = drawMaterial();
+    gl_Position = frame.projection * frame.view * draw.model * vec4(aPos, 1.0);
     
-    vec3 Pos = vec3(model * vec4(aPos, 1.0));
-    vec3 Normal = mat3(transpose(inverse(model))) * aNormal;
+    vec3 Pos = vec3(draw.model * vec4(aPos, 1.0));
+    vec3 Normal = draw.normalMatrix * decodeNormal(aNormal);
     
     // properties
     vec3 N = normalize(Normal);
-    vec3 V = normalize(viewPos - Pos);
+    vec3 V = normalize(frame.viewPos.xyz - Pos);
 
     vec3 result;
     
     // point lights
     for(int i = 0; i < NR_POINT_LIGHTS; i++)
-        result += CalcPointLight(material, pointLights[i], N, Pos, V);
+        result += CalcPointLight(material, pointLight(i), N, Pos, V);
     
     LightingColor = vec4(result, 1.0);
     
@@ -1,19 +1,51 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
+layout (location = 1) in vec4 aNormal;
 
 out vec3 FragPos;
 out vec3 Normal;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// the model matrix and material of the draw, in a slot of the streaming per-draw buffer (drawUniforms.h)
+layout (std140) uniform DrawData
+{
+    mat4 model;
+    mat3 normalMatrix; // inverse transpose of model's upper 3x3, worked out once per draw on the CPU
+    ivec4 material; // x = index into the material table
+} draw;
+
+struct FramePointLight {
+    vec4 position;  // xyz; w = 1 when the light is on
+    vec4 ambient;   // rgb; w = k_c
+    vec4 diffuse;   // rgb; w = k_l
+    vec4 specular;  // rgb; w = k_q
+};
+
+// camera and point lights, written once per frame and shared by every lighting program (frameUniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    FramePointLight lights[2];
+} frame;
+
+// Float normals arrive with w = 1. Packed vertices (vertexPacking.h) carry an octahedral
+// encoding in xy and w = -1.
+vec3 decodeNormal(vec4 n)
+{
+    if (n.w >= 0.0)
+        return n.xyz;
+    vec3 v = vec3(n.xy, 1.0 - abs(n.x) - abs(n.y));
+    if (v.z < 0.0)
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = frame.projection * frame.view * draw.model * vec4(aPos, 1.0);
     
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    FragPos = vec3(draw.model * vec4(aPos, 1.0));
+    Normal = draw.normalMatrix * decodeNormal(aNormal);
     
 }
@@ -0,0 +1,41 @@
+#version 400 core
+layout (location = 0) in vec2 aParam; // (around, along) the surface, both 0..1
+
+out vec2 ControlParam;
+out vec3 ControlWorldPos;
+
+// the model matrix and material of the draw, in a slot of the streaming per-draw buffer (drawUniforms.h)
+layout (std140) uniform DrawData
+{
+    mat4 model;
+    mat3 normalMatrix; // inverse transpose of model's upper 3x3, worked out once per draw on the CPU
+    ivec4 material; // x = index into the material table
+} draw;
+uniform int shape;          // 0 sphere, 1 cylinder or frustum, 2 cone, 3 disk (tessellatedSurfaces.h)
+uniform vec4 shapeParams;
+
+const float PI = 3.14159265359;
+
+// Object-space position of the point st on the surface; the same mapping as surfacePoint()
+// in tessEvaluationShaderForTessellatedSurface.tes and the meshes in revolution.h
+vec3 surfacePosition(vec2 st)
+{
+    float angle = st.x * 2.0 * PI * (shape == 3 ? shapeParams.z : 1.0);
+    vec3 around = vec3(cos(angle), 0.0, sin(angle));
+    if (shape == 0)
+    {
+        float stackAngle = PI / 2.0 - mix(shapeParams.y, shapeParams.z, st.y) * PI;
+        return shapeParams.x * (cos(stackAngle) * around + vec3(0.0, sin(stackAngle), 0.0));
+    }
+    if (shape == 1)
+        return mix(shapeParams.x, shapeParams.y, st.y) * around + vec3(0.0, (st.y - 0.5) * shapeParams.z, 0.0);
+    if (shape == 2)
+        return shapeParams.x * (1.0 - st.y) * around + vec3(0.0, st.y * shapeParams.y, 0.0);
+    return shapeParams.x * st.y * around + vec3(0.0, shapeParams.y, 0.0);
+}
+
+void main()
+{
+    ControlParam = aParam;
+    ControlWorldPos = vec3(draw.model * vec4(surfacePosition(aParam), 1.0));
+}
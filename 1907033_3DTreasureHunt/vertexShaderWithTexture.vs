@@ -1,6 +1,6 @@
 #version 330 core
 layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec3 aNormal;
+layout(location = 1) in vec4 aNormal;
 layout(location = 2) in vec2 aTexCoords;
 
 out vec3 FragPos;
@@ -9,8 +9,6 @@ out vec2 TexCoords;
 out vec3 VertexBlendedColor; // Pass blended color to the fragment shader
 
 struct Material {
-    sampler2D diffuse;
-    sampler2D specular;
     vec3 diffuseColor; // Diffuse surface color
     vec3 specularColor; // Specular surface color
     float shininess;
@@ -29,39 +27,116 @@ struct PointLight {
 
 #define NR_POINT_LIGHTS 2
 
-uniform mat4 model;      // Model matrix
-uniform mat4 view;       // View matrix
-uniform mat4 projection; // Projection matrix
+// the model matrix and material of the draw, in a slot of the streaming per-draw buffer (drawUniforms.h)
+layout (std140) uniform DrawData
+{
+    mat4 model;
+    mat3 normalMatrix; // inverse transpose of model's upper 3x3, worked out once per draw on the CPU
+    ivec4 material; // x = index into the material table
+} draw;
+uniform vec4 texRange = vec4(0.0, 0.0, 1.0, 1.0); // Texture coordinate offset and scale (boxGeometry.h)
+
+struct FramePointLight {
+    vec4 position;  // xyz; w = 1 when the light is on
+    vec4 ambient;   // rgb; w = k_c
+    vec4 diffuse;   // rgb; w = k_l
+    vec4 specular;  // rgb; w = k_q
+};
+
+// camera and point lights, written once per frame and shared by every lighting program (frameUniforms.h)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    FramePointLight lights[2];
+} frame;
+struct MaterialData {
+    vec4 ambient;   // rgb; w = shininess
+    vec4 diffuse;
+    vec4 specular;
+    vec4 emissive;
+};
 
-uniform vec3 viewPos;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform Material material;
+// every registered material, written once (materialTable.h)
+layout (std140) uniform MaterialTable
+{
+    MaterialData materials[256];
+};
+uniform sampler2D diffuseMap;  // texture unit 0
+uniform sampler2D specularMap; // texture unit 1
+Material material; // set from drawMaterial() first thing in main()
 
 uniform bool enableVertexBlending; // Toggle for blending in vertex shader
+uniform bool useTextureArray; // diffuse comes from a layer of materialLayers instead of diffuseMap
+uniform sampler2DArray materialLayers;
+uniform float diffuseLayer;
+uniform vec2 faceLayers = vec2(-1.0); // a two-texture box (chest.h): layers of its front (-z) face and of the others; x < 0 otherwise
 
 vec3 CalcPointLight(PointLight light, vec3 N, vec3 V, vec3 fragPos);
 
+// point light i of the frame block in this shader's PointLight form; the flicker is already in the colours
+PointLight pointLight(int i)
+{
+    FramePointLight l = frame.lights[i];
+    PointLight light;
+    light.position = l.position.xyz;
+    light.k_c = l.ambient.w;
+    light.k_l = l.diffuse.w;
+    light.k_q = l.specular.w;
+    light.ambient = l.ambient.rgb;
+    light.diffuse = l.diffuse.rgb;
+    light.specular = l.specular.rgb;
+    light.enabled = l.position.w > 0.5;
+    return light;
+}
+
+// Float normals arrive with w = 1. Packed vertices (vertexPacking.h) carry an octahedral
+// encoding in xy and w = -1.
+vec3 decodeNormal(vec4 n)
+{
+    if (n.w >= 0.0)
+        return n.xyz;
+    vec3 v = vec3(n.xy, 1.0 - abs(n.x) - abs(n.y));
+    if (v.z < 0.0)
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(v);
+}
+
+// this draw's entry of the material table in this shader's Material form
+Material drawMaterial()
+{
+    MaterialData m = materials[draw.material.x];
+    Material material;
+    material.diffuseColor = m.diffuse.rgb;
+    material.specularColor = m.specular.rgb;
+    material.shininess = m.ambient.w;
+    return material;
+}
+
 void main()
 {
+    material = drawMaterial();
     // Transformations
-    FragPos = vec3(model * vec4(aPos, 1.0)); // Compute world position
-    TexCoords = aTexCoords;
+    FragPos = vec3(draw.model * vec4(aPos, 1.0)); // Compute world position
+    TexCoords = texRange.xy + aTexCoords * texRange.zw;
 
     // Normal transformation
-    mat3 normalMatrix = mat3(transpose(inverse(model))); // Normal matrix for correct normal transformation
-    Normal = normalize(normalMatrix * aNormal);
+    mat3 normalMatrix = draw.normalMatrix;
+    Normal = normalize(normalMatrix * decodeNormal(aNormal));
 
     vec3 lightingResult = vec3(0.0); // Initialize lighting result
     bool anyLightEnabled = false;   // Track if any light is enabled
 
-    vec3 N = normalize(normalMatrix * aNormal);
-    vec3 V = normalize(viewPos - FragPos);
+    vec3 N = normalize(normalMatrix * decodeNormal(aNormal));
+    vec3 V = normalize(frame.viewPos.xyz - FragPos);
 
     // Accumulate lighting contributions from all point lights
     for (int i = 0; i < NR_POINT_LIGHTS; i++) {
-        if (pointLights[i].enabled) {
+        PointLight light = pointLight(i);
+        if (light.enabled) {
             anyLightEnabled = true;
-            lightingResult += CalcPointLight(pointLights[i], N, V, FragPos);
+            lightingResult += CalcPointLight(light, N, V, FragPos);
         }
     }
 
@@ -70,7 +145,12 @@ void main()
         lightingResult = vec3(0.0);
     }
 
-    vec3 textureColor = vec3(texture(material.diffuse, TexCoords)); // Sample texture color
+    // a chest picks its layer by whether the vertex is on its front (-z) face
+    float layer = diffuseLayer;
+    if (faceLayers.x >= 0.0)
+        layer = decodeNormal(aNormal).z < -0.5 ? faceLayers.x : faceLayers.y;
+    vec3 textureColor = useTextureArray ? vec3(texture(materialLayers, vec3(TexCoords, layer)))
+                                        : vec3(texture(diffuseMap, TexCoords)); // Sample texture color
 
     // Blending logic
     if (enableVertexBlending) {
@@ -79,7 +159,7 @@ void main()
         VertexBlendedColor = textureColor * lightingResult; // Apply lighting to texture directly
     }
 
-    gl_Position = projection * view * model * vec4(aPos, 1.0); // Final position in clip space
+    gl_Position = frame.projection * frame.view * draw.model * vec4(aPos, 1.0); // Final position in clip space
 }
 
 // Function to calculate lighting effect from a point light